@@ -0,0 +1,132 @@
+#ifndef LIFE_GRID_H
+#define LIFE_GRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+/*
+Bit-packed Game of Life grid
+- Each cell is one bit, 64 cells to a uint64_t word
+  * Cell x of a row is bit x % 64 of word x / 64
+- Cells outside the grid are always dead, as with the bordered grid in
+  1Conway_gameOfLife.cpp
+- Two buffers: step() reads the current generation from one and writes the
+  next generation to the other, then swaps them
+- Every row has a zero guard word at each end and there is a zero guard row
+  above and below the grid, so the stepping loop never has to check for edges
+*/
+class life_grid {
+
+private:
+  int width;
+  int height;
+  int words;     // words in a row, not counting the guard words
+  size_t stride; // words from one row to the next
+  std::vector<uint64_t> cells;
+  std::vector<uint64_t> next;
+
+public:
+  static constexpr int max_dimension = 65536;
+
+  // throws std::invalid_argument if either dimension is not in
+  // 1..max_dimension
+  life_grid(int width, int height);
+
+  int get_width() const { return width; }
+  int get_height() const { return height; }
+  int words_per_row() const { return words; }
+
+  // the words of row y, row(y)[-1] and row(y)[words_per_row()] are guards
+  uint64_t *row(int y) { return cells.data() + (y + 1) * stride + 1; }
+  const uint64_t *row(int y) const {
+    return cells.data() + (y + 1) * stride + 1;
+  }
+
+  bool get(int x, int y) const { return row(y)[x / 64] >> (x % 64) & 1; }
+  void set(int x, int y, bool alive) {
+    uint64_t bit = uint64_t{1} << (x % 64);
+    if (alive) {
+      row(y)[x / 64] |= bit;
+    } else {
+      row(y)[x / 64] &= ~bit;
+    }
+  }
+
+  void clear();
+  // each cell is alive with probability 1 / one_in
+  void randomize(std::mt19937_64 &rng, int one_in = 5);
+  size_t population() const;
+
+  void step(); // advance one generation
+
+  // the two halves of step(), for steppers which split the work
+  // step_rows writes the next generation of rows [y0, y1) into the back
+  // buffer, reading rows y0 - 1 to y1 of the current generation.
+  // swap_buffers makes the back buffer the current generation
+  void step_rows(int y0, int y1);
+  void swap_buffers() { cells.swap(next); }
+};
+
+// adds three one-bit numbers in every bit position at once
+inline void full_add(uint64_t a, uint64_t b, uint64_t c, uint64_t &sum,
+                     uint64_t &carry) {
+  uint64_t t = a ^ b;
+  sum = t ^ c;
+  carry = (a & b) | (t & c);
+}
+
+/*
+The next generation of the 64 cells in here[0]
+- above[0] and below[0] are the words of the rows above and below, and
+  [-1] and [1] of each are the words to the west and east
+- The eight neighbours of all 64 cells are eight words: the words above,
+  here and below, each shifted one cell left and right, with the bit that
+  falls off taken from the adjacent word
+- The neighbour counts are added up with full adders working on whole words,
+  which gives the count for every cell as three bits: ones, twos and fours
+  * A count of 8 wraps around to 0, which is fine as both mean "dead"
+- A cell is alive in the next generation if it has 3 neighbours, or if it is
+  alive and has 2 neighbours:
+    twos && !fours && (ones || alive)
+- There are no branches, so a loop of these can be vectorized
+*/
+inline uint64_t next_word(const uint64_t *above, const uint64_t *here,
+                          const uint64_t *below) {
+  // cell x - 1 is the neighbour to the west, so shifting left lines up the
+  // west neighbours, and shifting right the east neighbours
+  uint64_t a = above[0];
+  uint64_t a_west = (a << 1) | (above[-1] >> 63);
+  uint64_t a_east = (a >> 1) | (above[1] << 63);
+  uint64_t c = here[0];
+  uint64_t c_west = (c << 1) | (here[-1] >> 63);
+  uint64_t c_east = (c >> 1) | (here[1] << 63);
+  uint64_t b = below[0];
+  uint64_t b_west = (b << 1) | (below[-1] >> 63);
+  uint64_t b_east = (b >> 1) | (below[1] << 63);
+
+  uint64_t s_above, c_above, s_mid, c_mid;
+  full_add(a_west, a, a_east, s_above, c_above);
+  full_add(c_west, c_east, b_west, s_mid, c_mid);
+  uint64_t s_below = b ^ b_east;
+  uint64_t c_below = b & b_east;
+
+  uint64_t ones, twos_a;
+  full_add(s_above, s_mid, s_below, ones, twos_a);
+  uint64_t twos_b, fours_a;
+  full_add(c_above, c_mid, c_below, twos_b, fours_a);
+  uint64_t twos = twos_b ^ twos_a;
+  uint64_t fours = fours_a ^ (twos_b & twos_a);
+
+  return twos & ~fours & (ones | c);
+}
+
+// the next generation of one row, computed 64 cells at a time
+// above, here and below point at the first word of three consecutive rows
+// and must have a readable guard word on each side
+void step_row(const uint64_t *above, const uint64_t *here,
+              const uint64_t *below, uint64_t *out, int words,
+              uint64_t last_mask);
+
+#endif // LIFE_GRID_H
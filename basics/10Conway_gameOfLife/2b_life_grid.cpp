@@ -0,0 +1,64 @@
+#include "2a_life_grid.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <string>
+
+void step_row(const uint64_t *above, const uint64_t *here,
+              const uint64_t *below, uint64_t *out, int words,
+              uint64_t last_mask) {
+  for (int i = 0; i < words; ++i) {
+    out[i] = next_word(above + i, here + i, below + i);
+  }
+  // cells past the right hand edge must stay dead
+  out[words - 1] &= last_mask;
+}
+
+life_grid::life_grid(int width, int height)
+    : width(width), height(height), words((width + 63) / 64),
+      stride(words + 2) {
+  if (width < 1 || height < 1 || width > max_dimension ||
+      height > max_dimension) {
+    throw std::invalid_argument("grid dimensions must be between 1 and " +
+                                std::to_string(max_dimension));
+  }
+  cells.assign(stride * (height + 2), 0);
+  next.assign(stride * (height + 2), 0);
+}
+
+void life_grid::clear() { std::fill(cells.begin(), cells.end(), 0); }
+
+void life_grid::randomize(std::mt19937_64 &rng, int one_in) {
+  std::uniform_int_distribution<int> d(0, one_in - 1);
+  clear();
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      if (d(rng) == 0) {
+        set(x, y, true);
+      }
+    }
+  }
+}
+
+size_t life_grid::population() const {
+  size_t n = 0;
+  for (uint64_t w : cells) {
+    n += std::popcount(w); // the guard words are always zero
+  }
+  return n;
+}
+
+void life_grid::step_rows(int y0, int y1) {
+  uint64_t last_mask =
+      width % 64 == 0 ? ~uint64_t{0} : (uint64_t{1} << (width % 64)) - 1;
+  for (int y = y0; y < y1; ++y) {
+    step_row(row(y - 1), row(y), row(y + 1),
+             next.data() + (y + 1) * stride + 1, words, last_mask);
+  }
+}
+
+void life_grid::step() {
+  step_rows(0, height);
+  swap_buffers();
+}
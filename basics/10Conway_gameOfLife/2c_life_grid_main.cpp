@@ -0,0 +1,125 @@
+/*
+Generations per second: bit-packed grid vs. a plain int grid
+- The naive version is the obvious implementation of the program logic in
+  1Conway_gameOfLife.cpp: an int per cell, and the eight neighbours of every
+  cell counted one at a time
+- Both start from the same random board, and the boards are compared after
+  the run to check that the bit-packed engine gets the same answer
+
+build: g++ -std=c++20 -O3 -march=native 2b_life_grid.cpp 2c_life_grid_main.cpp
+*/
+
+#include "2a_life_grid.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// one int per cell with a dead border all the way round, as in lesson 1
+class naive_grid {
+
+private:
+  int width;
+  int height;
+  vector<int> cells;
+  vector<int> next;
+
+  int &at(vector<int> &v, int x, int y) {
+    return v[(y + 1) * (width + 2) + x + 1];
+  }
+
+public:
+  naive_grid(const life_grid &g)
+      : width(g.get_width()), height(g.get_height()),
+        cells((width + 2) * (height + 2)), next(cells.size()) {
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        at(cells, x, y) = g.get(x, y);
+      }
+    }
+  }
+
+  bool get(int x, int y) { return at(cells, x, y); }
+
+  void step() {
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        int n = 0;
+        for (int dy = -1; dy <= 1; ++dy) {
+          for (int dx = -1; dx <= 1; ++dx) {
+            if (dx != 0 || dy != 0) {
+              n += at(cells, x + dx, y + dy);
+            }
+          }
+        }
+        at(next, x, y) = (n == 3 || (n == 2 && at(cells, x, y))) ? 1 : 0;
+      }
+    }
+    cells.swap(next);
+  }
+};
+
+// run step() until at least min_seconds have passed, return generations/sec
+template <typename Grid>
+double generations_per_second(Grid &g, int &generations) {
+  const double min_seconds = 0.5;
+  auto start = steady_clock::now();
+  duration<double> elapsed{0};
+  generations = 0;
+  while (elapsed.count() < min_seconds) {
+    g.step();
+    ++generations;
+    elapsed = steady_clock::now() - start;
+  }
+  return generations / elapsed.count();
+}
+
+int main() {
+  mt19937_64 rng(42);
+
+  cout << setw(12) << "size" << setw(16) << "naive gen/s" << setw(16)
+       << "packed gen/s" << setw(10) << "speedup" << setw(8) << "match"
+       << "\n";
+
+  for (int size : {79, 256, 1024, 4096, 16384}) {
+    life_grid packed(size, size);
+    packed.randomize(rng);
+
+    // the naive grid is far too slow for the big boards
+    double naive_rate = 0;
+    bool match = true;
+    if (size <= 1024) {
+      naive_grid naive(packed);
+      life_grid check = packed;
+      int generations;
+      naive_rate = generations_per_second(naive, generations);
+      for (int i = 0; i < generations; ++i) {
+        check.step();
+      }
+      for (int y = 0; y < size && match; ++y) {
+        for (int x = 0; x < size && match; ++x) {
+          match = naive.get(x, y) == check.get(x, y);
+        }
+      }
+    }
+
+    int generations;
+    double packed_rate = generations_per_second(packed, generations);
+
+    cout << setw(12) << to_string(size) + "x" + to_string(size) << fixed
+         << setprecision(1) << setw(16);
+    if (naive_rate > 0) {
+      cout << naive_rate << setw(16) << packed_rate << setw(10)
+           << packed_rate / naive_rate << setw(8) << (match ? "yes" : "NO");
+    } else {
+      cout << "-" << setw(16) << packed_rate << setw(10) << "-" << setw(8)
+           << "-";
+    }
+    cout << "\n";
+  }
+}
@@ -0,0 +1,32 @@
+#ifndef BANDED_STEPPER_H
+#define BANDED_STEPPER_H
+
+#include "2a_life_grid.h"
+
+/*
+Multi-threaded stepping of a life_grid
+- The rows are split into one band per thread
+- For each generation every thread steps its own band. The only rows it
+  reads that belong to another band are the halo rows, the row just above
+  and the row just below the band
+  * The current generation is read-only while a generation is being worked
+    out, so the halo rows need no locking
+- The threads meet at a std::barrier after each generation. The barrier's
+  completion function swaps the grid's buffers, once, before any thread
+  starts on the next generation
+*/
+class banded_stepper {
+
+private:
+  life_grid &grid;
+  unsigned threads;
+
+public:
+  // threads == 0 means one per core
+  banded_stepper(life_grid &grid, unsigned threads = 0);
+
+  unsigned get_threads() const { return threads; }
+  void run(int generations);
+};
+
+#endif // BANDED_STEPPER_H
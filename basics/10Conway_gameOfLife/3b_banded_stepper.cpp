@@ -0,0 +1,46 @@
+#include "3a_banded_stepper.h"
+
+#include <algorithm>
+#include <barrier>
+#include <thread>
+#include <vector>
+
+banded_stepper::banded_stepper(life_grid &grid, unsigned threads)
+    : grid(grid), threads(threads) {
+  if (this->threads == 0) {
+    this->threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  // every band needs at least one row
+  this->threads = std::min<unsigned>(this->threads, grid.get_height());
+}
+
+void banded_stepper::run(int generations) {
+  if (generations <= 0) {
+    return;
+  }
+  if (threads == 1) {
+    for (int g = 0; g < generations; ++g) {
+      grid.step();
+    }
+    return;
+  }
+
+  std::barrier sync(threads, [this]() noexcept { grid.swap_buffers(); });
+
+  auto work = [&](unsigned band) {
+    int height = grid.get_height();
+    int y0 = static_cast<int>(static_cast<long long>(height) * band / threads);
+    int y1 =
+        static_cast<int>(static_cast<long long>(height) * (band + 1) / threads);
+    for (int g = 0; g < generations; ++g) {
+      grid.step_rows(y0, y1);
+      sync.arrive_and_wait();
+    }
+  };
+
+  std::vector<std::jthread> workers;
+  for (unsigned band = 1; band < threads; ++band) {
+    workers.emplace_back(work, band);
+  }
+  work(0); // the calling thread takes the first band
+}
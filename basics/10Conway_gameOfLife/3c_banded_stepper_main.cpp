@@ -0,0 +1,64 @@
+/*
+Scaling of the banded stepper from 1 to N threads on a 16k x 16k board
+- Each run starts from the same random board and the result is compared with
+  the single-threaded life_grid::step()
+
+build: g++ -std=c++20 -O3 -march=native -pthread 2b_life_grid.cpp
+       3b_banded_stepper.cpp 3c_banded_stepper_main.cpp
+*/
+
+#include "3a_banded_stepper.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+
+int main() {
+  const int size = 16384;
+  const int generations = 20;
+
+  mt19937_64 rng(42);
+  life_grid start(size, size);
+  start.randomize(rng);
+
+  life_grid expected = start;
+  for (int g = 0; g < generations; ++g) {
+    expected.step();
+  }
+
+  const unsigned cores = max(thread::hardware_concurrency(), 1u);
+  cout << size << "x" << size << ", " << generations << " generations, "
+       << cores << " cores\n";
+  cout << setw(10) << "threads" << setw(12) << "gen/s" << setw(10)
+       << "speedup" << setw(8) << "match" << "\n";
+
+  double single = 0;
+  for (unsigned threads = 1; threads <= 2 * cores; threads *= 2) {
+    life_grid grid = start;
+    banded_stepper stepper(grid, threads);
+    auto t0 = steady_clock::now();
+    stepper.run(generations);
+    duration<double> elapsed = steady_clock::now() - t0;
+
+    double rate = generations / elapsed.count();
+    if (threads == 1) {
+      single = rate;
+    }
+
+    bool match = true;
+    for (int y = 0; y < size && match; ++y) {
+      match = equal(grid.row(y), grid.row(y) + grid.words_per_row(),
+                    expected.row(y));
+    }
+
+    cout << setw(10) << threads << fixed << setprecision(1) << setw(12)
+         << rate << setw(10) << rate / single << setw(8)
+         << (match ? "yes" : "NO") << "\n";
+  }
+}
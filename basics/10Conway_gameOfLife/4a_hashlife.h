@@ -0,0 +1,101 @@
+#ifndef HASHLIFE_H
+#define HASHLIFE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/*
+Hashlife
+- The universe is a quadtree. A node at level k is a 2^k x 2^k square made of
+  four level k - 1 squares, and a level 0 node is a single cell, dead or alive
+- Nodes are hash-consed: there is only ever one node with a given four
+  children, so identical regions anywhere in the pattern, at any time, are
+  the same node
+- The RESULT of a level k node is the centre 2^(k-1) square advanced
+  2^(k-2) generations. It only depends on the node, so it is worked out once
+  and memoized in the node. Repeating patterns then cost almost nothing to
+  run for billions of generations
+- Smaller steps of 2^j generations use the same recursion, stopping the time
+  advance once 2^j generations have been done. That result is memoized too,
+  for the most recent step size
+- All nodes live in one arena and refer to each other by index. When the
+  arena grows past the node limit, the nodes which are no longer reachable
+  from the current pattern are thrown away and all the memoized results are
+  forgotten. The check happens between steps, so a single very big step can
+  go over the limit for a while
+- The origin is the centre of the root square, y grows downwards
+*/
+class hashlife {
+
+private:
+  using index = uint32_t;
+  static constexpr index none = UINT32_MAX;
+
+  struct node {
+    index nw, ne, sw, se; // children, unused for the two leaves
+    index result;         // memoized RESULT, or none
+    index step_result;    // memoized result for a 2^step_log2 step, or none
+    int8_t step_log2;
+    uint8_t level;
+    uint64_t population;
+  };
+
+  struct key {
+    index nw, ne, sw, se;
+    bool operator==(const key &) const = default;
+  };
+  struct key_hash {
+    size_t operator()(const key &k) const {
+      uint64_t h = k.nw;
+      h = h * 0x9e3779b97f4a7c15 + k.ne;
+      h = h * 0x9e3779b97f4a7c15 + k.sw;
+      h = h * 0x9e3779b97f4a7c15 + k.se;
+      return h ^ (h >> 32);
+    }
+  };
+
+  static constexpr index dead = 0;
+  static constexpr index alive = 1;
+
+  std::vector<node> nodes;
+  std::unordered_map<key, index, key_hash> table;
+  std::vector<index> empty_nodes; // the empty node for each level
+  index root;
+  uint64_t generation{0};
+  size_t max_nodes;
+  size_t collections{0};
+
+  index join(index nw, index ne, index sw, index se);
+  index empty(int level);
+  index centre(index n);
+  index expand(index n);
+  index base_step(index n);
+  index step(index n, int log2_generations);
+  index set(index n, int64_t x, int64_t y, bool value);
+  bool get(index n, int64_t x, int64_t y) const;
+  bool fits_in_centre(index n) const;
+  index copy_into(index n, std::vector<node> &to, std::vector<index> &remap);
+  void collect();
+
+public:
+  // at most about max_nodes nodes are kept between steps
+  explicit hashlife(size_t max_nodes = size_t{1} << 24);
+
+  void set(int64_t x, int64_t y, bool value = true);
+  bool get(int64_t x, int64_t y) const;
+
+  // advance the pattern by 2^log2_generations generations
+  void step_pow2(int log2_generations);
+  // advance the pattern by any number of generations
+  void advance(uint64_t generations);
+
+  uint64_t get_generation() const { return generation; }
+  uint64_t population() const { return nodes[root].population; }
+  int root_level() const { return nodes[root].level; }
+  size_t node_count() const { return nodes.size(); }
+  size_t collection_count() const { return collections; }
+};
+
+#endif // HASHLIFE_H
@@ -0,0 +1,317 @@
+#include "4a_hashlife.h"
+
+#include <stdexcept>
+
+namespace {
+
+// coordinates are int64_t, so the root can't grow any bigger than this
+constexpr int max_level = 62;
+
+} // namespace
+
+hashlife::hashlife(size_t max_nodes) : max_nodes(max_nodes) {
+  nodes.push_back({none, none, none, none, none, none, -1, 0, 0}); // dead
+  nodes.push_back({none, none, none, none, none, none, -1, 0, 1}); // alive
+  root = empty(3);
+}
+
+// the one node with these four children
+// no node& is held across this call anywhere, since push_back may move them
+hashlife::index hashlife::join(index nw, index ne, index sw, index se) {
+  key k{nw, ne, sw, se};
+  auto it = table.find(k);
+  if (it != table.end()) {
+    return it->second;
+  }
+  const node &a = nodes[nw];
+  const node &b = nodes[ne];
+  const node &c = nodes[sw];
+  const node &d = nodes[se];
+  node n{nw,
+         ne,
+         sw,
+         se,
+         none,
+         none,
+         -1,
+         static_cast<uint8_t>(a.level + 1),
+         a.population + b.population + c.population + d.population};
+  index i = static_cast<index>(nodes.size());
+  nodes.push_back(n);
+  table.emplace(k, i);
+  return i;
+}
+
+hashlife::index hashlife::empty(int level) {
+  if (empty_nodes.empty()) {
+    empty_nodes.push_back(dead);
+  }
+  while (static_cast<int>(empty_nodes.size()) <= level) {
+    index e = empty_nodes.back();
+    empty_nodes.push_back(join(e, e, e, e));
+  }
+  return empty_nodes[level];
+}
+
+// the centre half of a node, one level down
+hashlife::index hashlife::centre(index n) {
+  node m = nodes[n];
+  return join(nodes[m.nw].se, nodes[m.ne].sw, nodes[m.sw].ne, nodes[m.se].nw);
+}
+
+// the same pattern, centred in a node one level up
+hashlife::index hashlife::expand(index n) {
+  node m = nodes[n];
+  if (m.level >= max_level) {
+    throw std::overflow_error("pattern has grown too large");
+  }
+  index e = empty(m.level - 1);
+  return join(join(e, e, e, m.nw), join(e, e, m.ne, e), join(e, m.sw, e, e),
+              join(m.se, e, e, e));
+}
+
+// one generation of the centre 2x2 of a 4x4 node
+hashlife::index hashlife::base_step(index n) {
+  // gather the 16 cells, bit (y * 4 + x)
+  unsigned cells = 0;
+  node m = nodes[n];
+  const index quadrants[4]{m.nw, m.ne, m.sw, m.se};
+  for (int q = 0; q < 4; ++q) {
+    const node &c = nodes[quadrants[q]];
+    int x0 = (q % 2) * 2;
+    int y0 = (q / 2) * 2;
+    const index leaves[4]{c.nw, c.ne, c.sw, c.se};
+    for (int l = 0; l < 4; ++l) {
+      if (leaves[l] == alive) {
+        cells |= 1u << ((y0 + l / 2) * 4 + x0 + l % 2);
+      }
+    }
+  }
+
+  index next[4];
+  for (int i = 0; i < 4; ++i) {
+    int x = 1 + i % 2;
+    int y = 1 + i / 2;
+    int count = 0;
+    for (int dy = -1; dy <= 1; ++dy) {
+      for (int dx = -1; dx <= 1; ++dx) {
+        if (dx != 0 || dy != 0) {
+          count += cells >> ((y + dy) * 4 + x + dx) & 1;
+        }
+      }
+    }
+    bool was_alive = cells >> (y * 4 + x) & 1;
+    next[i] = (count == 3 || (count == 2 && was_alive)) ? alive : dead;
+  }
+  return join(next[0], next[1], next[2], next[3]);
+}
+
+/*
+The centre half of node n, advanced 2^log2_generations generations
+- log2_generations can be at most level - 2, which is the RESULT
+- The node is cut into nine overlapping squares one level down. Each of
+  those is advanced, giving nine squares two levels down, a quarter of the
+  way into the time step for the RESULT
+- These are put back together as four overlapping squares one level down,
+  which are advanced again to make the four quarters of the result
+- For a smaller step the second advance is skipped, and the centres of the
+  four squares are used as they are
+*/
+hashlife::index hashlife::step(index n, int log2_generations) {
+  node m = nodes[n];
+  if (m.population == 0) {
+    return empty(m.level - 1);
+  }
+  bool full = log2_generations == m.level - 2;
+  if (full && m.result != none) {
+    return m.result;
+  }
+  if (!full && m.step_log2 == log2_generations && m.step_result != none) {
+    return m.step_result;
+  }
+
+  index result;
+  if (m.level == 2) {
+    result = base_step(n);
+  } else {
+    node a = nodes[m.nw];
+    node b = nodes[m.ne];
+    node c = nodes[m.sw];
+    node d = nodes[m.se];
+
+    index n00 = m.nw;
+    index n01 = join(a.ne, b.nw, a.se, b.sw);
+    index n02 = m.ne;
+    index n10 = join(a.sw, a.se, c.nw, c.ne);
+    index n11 = join(a.se, b.sw, c.ne, d.nw);
+    index n12 = join(b.sw, b.se, d.nw, d.ne);
+    index n20 = m.sw;
+    index n21 = join(c.ne, d.nw, c.se, d.sw);
+    index n22 = m.se;
+
+    // a full step advances twice, 2^(level - 3) generations each time
+    int first = full ? m.level - 3 : log2_generations;
+    index r00 = step(n00, first);
+    index r01 = step(n01, first);
+    index r02 = step(n02, first);
+    index r10 = step(n10, first);
+    index r11 = step(n11, first);
+    index r12 = step(n12, first);
+    index r20 = step(n20, first);
+    index r21 = step(n21, first);
+    index r22 = step(n22, first);
+
+    index q_nw = join(r00, r01, r10, r11);
+    index q_ne = join(r01, r02, r11, r12);
+    index q_sw = join(r10, r11, r20, r21);
+    index q_se = join(r11, r12, r21, r22);
+
+    if (full) {
+      result = join(step(q_nw, first), step(q_ne, first), step(q_sw, first),
+                    step(q_se, first));
+    } else {
+      result = join(centre(q_nw), centre(q_ne), centre(q_sw), centre(q_se));
+    }
+  }
+
+  node &memo = nodes[n];
+  if (full) {
+    memo.result = result;
+  } else {
+    memo.step_result = result;
+    memo.step_log2 = static_cast<int8_t>(log2_generations);
+  }
+  return result;
+}
+
+// true if everything alive in n is in its centre quarter, so that nothing
+// can escape the RESULT square however far it moves in 2^(level - 3)
+// generations
+bool hashlife::fits_in_centre(index n) const {
+  const node &m = nodes[n];
+  uint64_t inner = nodes[nodes[nodes[m.nw].se].se].population +
+                   nodes[nodes[nodes[m.ne].sw].sw].population +
+                   nodes[nodes[nodes[m.sw].ne].ne].population +
+                   nodes[nodes[nodes[m.se].nw].nw].population;
+  return inner == m.population;
+}
+
+void hashlife::step_pow2(int log2_generations) {
+  while (nodes[root].level < log2_generations + 3 || !fits_in_centre(root)) {
+    root = expand(root);
+  }
+  root = step(root, log2_generations);
+  generation += uint64_t{1} << log2_generations;
+  if (nodes.size() > max_nodes) {
+    collect();
+  }
+}
+
+void hashlife::advance(uint64_t generations) {
+  for (int bit = 63; bit >= 0; --bit) {
+    if (generations >> bit & 1) {
+      step_pow2(bit);
+    }
+  }
+}
+
+// x and y are relative to the centre of n
+hashlife::index hashlife::set(index n, int64_t x, int64_t y, bool value) {
+  node m = nodes[n];
+  if (m.level == 1) {
+    index leaf = value ? alive : dead;
+    index nw = (x < 0 && y < 0) ? leaf : m.nw;
+    index ne = (x >= 0 && y < 0) ? leaf : m.ne;
+    index sw = (x < 0 && y >= 0) ? leaf : m.sw;
+    index se = (x >= 0 && y >= 0) ? leaf : m.se;
+    return join(nw, ne, sw, se);
+  }
+  int64_t offset = int64_t{1} << (m.level - 2);
+  int64_t cx = x < 0 ? x + offset : x - offset;
+  int64_t cy = y < 0 ? y + offset : y - offset;
+  if (y < 0) {
+    if (x < 0) {
+      return join(set(m.nw, cx, cy, value), m.ne, m.sw, m.se);
+    }
+    return join(m.nw, set(m.ne, cx, cy, value), m.sw, m.se);
+  }
+  if (x < 0) {
+    return join(m.nw, m.ne, set(m.sw, cx, cy, value), m.se);
+  }
+  return join(m.nw, m.ne, m.sw, set(m.se, cx, cy, value));
+}
+
+void hashlife::set(int64_t x, int64_t y, bool value) {
+  // grow until the root covers (x, y)
+  while (true) {
+    int64_t half = int64_t{1} << (nodes[root].level - 1);
+    if (x >= -half && x < half && y >= -half && y < half) {
+      break;
+    }
+    root = expand(root);
+  }
+  root = set(root, x, y, value);
+}
+
+bool hashlife::get(index n, int64_t x, int64_t y) const {
+  const node &m = nodes[n];
+  if (m.population == 0) {
+    return false;
+  }
+  if (m.level == 1) {
+    index leaf = y < 0 ? (x < 0 ? m.nw : m.ne) : (x < 0 ? m.sw : m.se);
+    return leaf == alive;
+  }
+  int64_t offset = int64_t{1} << (m.level - 2);
+  int64_t cx = x < 0 ? x + offset : x - offset;
+  int64_t cy = y < 0 ? y + offset : y - offset;
+  index child = y < 0 ? (x < 0 ? m.nw : m.ne) : (x < 0 ? m.sw : m.se);
+  return get(child, cx, cy);
+}
+
+bool hashlife::get(int64_t x, int64_t y) const {
+  int64_t half = int64_t{1} << (nodes[root].level - 1);
+  if (x < -half || x >= half || y < -half || y >= half) {
+    return false;
+  }
+  return get(root, x, y);
+}
+
+// copy node n and everything below it into the new arena, children first
+hashlife::index hashlife::copy_into(index n, std::vector<node> &to,
+                                    std::vector<index> &remap) {
+  if (remap[n] != none) {
+    return remap[n];
+  }
+  node m = nodes[n];
+  m.nw = copy_into(m.nw, to, remap);
+  m.ne = copy_into(m.ne, to, remap);
+  m.sw = copy_into(m.sw, to, remap);
+  m.se = copy_into(m.se, to, remap);
+  m.result = none;
+  m.step_result = none;
+  m.step_log2 = -1;
+  remap[n] = static_cast<index>(to.size());
+  to.push_back(m);
+  return remap[n];
+}
+
+// keep only the nodes the current pattern is made of
+void hashlife::collect() {
+  std::vector<node> live;
+  std::vector<index> remap(nodes.size(), none);
+  live.push_back(nodes[dead]);
+  live.push_back(nodes[alive]);
+  remap[dead] = dead;
+  remap[alive] = alive;
+  root = copy_into(root, live, remap);
+
+  nodes.swap(live);
+  table.clear();
+  for (index i = alive + 1; i < nodes.size(); ++i) {
+    const node &m = nodes[i];
+    table.emplace(key{m.nw, m.ne, m.sw, m.se}, i);
+  }
+  empty_nodes.clear();
+  ++collections;
+}
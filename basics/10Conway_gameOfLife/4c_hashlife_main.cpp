@@ -0,0 +1,112 @@
+/*
+Hashlife on some classic patterns
+- First a check: acorn is run for 1000 generations with hashlife and with the
+  bit-packed grid, and the two boards are compared
+- Then each pattern is advanced by 2^10, 2^20, 2^30 and 2^40 generations,
+  with the node limit set low enough that garbage collection happens
+  * Gosper glider gun: 36 cells, a new glider every 30 generations
+  * Two small patterns which grow without limit by turning into a
+    block-laying switch engine, a puffer which leaves a trail of blocks
+  * Acorn, a methuselah which settles down after 5206 generations
+
+build: g++ -std=c++20 -O2 2b_life_grid.cpp 4b_hashlife.cpp 4c_hashlife_main.cpp
+*/
+
+#include "2a_life_grid.h"
+#include "4a_hashlife.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+struct pattern {
+  const char *name;
+  vector<string> rows; // 'O' is alive
+};
+
+const pattern gosper_gun{"Gosper glider gun",
+                         {
+                             "........................O...........",
+                             "......................O.O...........",
+                             "............OO......OO............OO",
+                             "...........O...O....OO............OO",
+                             "OO........O.....O...OO..............",
+                             "OO........O...O.OO....O.O...........",
+                             "..........O.....O.......O...........",
+                             "...........O...O....................",
+                             "............OO......................",
+                         }};
+
+const pattern five_by_five{"5x5 infinite growth",
+                           {"OOO.O", "O....", "...OO", ".OO.O", "O.O.O"}};
+
+const pattern one_row{"1 cell high infinite growth",
+                      {"OOOOOOOO.OOOOO...OOO......OOOOOOO.OOOOO"}};
+
+const pattern acorn{"Acorn", {".O.....", "...O...", "OO..OOO"}};
+
+template <typename Grid>
+void place(Grid &g, const pattern &p, int x0, int y0) {
+  for (int y = 0; y < static_cast<int>(p.rows.size()); ++y) {
+    for (int x = 0; x < static_cast<int>(p.rows[y].size()); ++x) {
+      if (p.rows[y][x] == 'O') {
+        g.set(x0 + x, y0 + y, true);
+      }
+    }
+  }
+}
+
+bool check_against_grid() {
+  const int size = 512;
+  const int generations = 1000;
+  life_grid grid(size, size);
+  hashlife life;
+  place(grid, acorn, size / 2, size / 2);
+  place(life, acorn, 0, 0);
+  for (int g = 0; g < generations; ++g) {
+    grid.step();
+  }
+  life.advance(generations);
+
+  if (grid.population() != life.population()) {
+    return false;
+  }
+  for (int y = 0; y < size; ++y) {
+    for (int x = 0; x < size; ++x) {
+      if (grid.get(x, y) != life.get(x - size / 2, y - size / 2)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+int main() {
+  cout << "acorn after 1000 generations matches life_grid: "
+       << (check_against_grid() ? "yes" : "NO") << "\n\n";
+
+  const size_t max_nodes = size_t{1} << 16;
+  cout << setw(30) << "pattern" << setw(14) << "generations" << setw(18)
+       << "population" << setw(12) << "ms" << setw(10) << "nodes"
+       << setw(6) << "gc" << "\n";
+
+  for (const pattern *p : {&gosper_gun, &five_by_five, &one_row, &acorn}) {
+    hashlife life(max_nodes);
+    place(life, *p, 0, 0);
+    for (int log2 : {10, 20, 30, 40}) {
+      uint64_t target = uint64_t{1} << log2;
+      auto start = steady_clock::now();
+      life.advance(target - life.get_generation());
+      duration<double, milli> elapsed = steady_clock::now() - start;
+      cout << setw(30) << p->name << setw(14) << ("2^" + to_string(log2))
+           << setw(18) << life.population() << setw(12) << fixed
+           << setprecision(1) << elapsed.count() << setw(10)
+           << life.node_count() << setw(6) << life.collection_count() << "\n";
+    }
+  }
+}
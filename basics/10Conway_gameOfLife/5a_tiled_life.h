@@ -0,0 +1,69 @@
+#ifndef TILED_LIFE_H
+#define TILED_LIFE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/*
+Sparse Game of Life with active tile tracking
+- The universe is split into 64x64 tiles, one uint64_t per tile row, kept in
+  a hash map keyed by tile coordinates. Only tiles with something in them
+  exist, so the universe has no edges and an empty region costs nothing
+- A tile can only change if it, or one of its eight neighbours, changed in
+  the last generation. Otherwise it and everything around it are the same as
+  a generation ago, so its next generation is the same as this one
+- So each step only recomputes the tiles which changed last time and their
+  neighbours. Still lifes and empty space are never looked at again
+- A missing neighbour is created when a changed tile has live cells on the
+  edge next to it, since that is the only way something can be born there
+- Tiles which are empty and didn't change are dropped
+- Each tile keeps pointers to its eight neighbours, so the hash map is only
+  used when a tile is created or dropped, never while stepping
+- Each tile word is stepped with next_word() from the bit-packed grid, using
+  the neighbouring tiles' words as the guard words
+*/
+class tiled_life {
+
+private:
+  static constexpr int tile_size = 64;
+
+  struct tile {
+    int32_t tx;
+    int32_t ty;
+    uint64_t cells[tile_size]{};
+    uint64_t next[tile_size]{};
+    tile *around[3][3]{}; // [dy + 1][dx + 1], null where there is no tile
+    bool changed{false};  // changed in the last generation, or by set()
+    bool active{false};
+  };
+
+  // unordered_map never moves its elements, so the pointers stay valid
+  std::unordered_map<uint64_t, tile> tiles;
+  std::vector<tile *> changed;
+  std::vector<tile *> active;
+  uint64_t generation{0};
+
+  static uint64_t key(int32_t tx, int32_t ty) {
+    return uint64_t{static_cast<uint32_t>(tx)} << 32 |
+           static_cast<uint32_t>(ty);
+  }
+  tile &find_or_create(int32_t tx, int32_t ty);
+  void remove(tile &t);
+  void compute(tile &t);
+
+public:
+  void set(int64_t x, int64_t y, bool alive = true);
+  bool get(int64_t x, int64_t y) const;
+
+  void step();
+
+  uint64_t get_generation() const { return generation; }
+  size_t population() const;
+  size_t tile_count() const { return tiles.size(); }
+  // tiles recomputed by the last step
+  size_t active_tiles() const { return active.size(); }
+};
+
+#endif // TILED_LIFE_H
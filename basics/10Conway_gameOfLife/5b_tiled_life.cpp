@@ -0,0 +1,175 @@
+#include "5a_tiled_life.h"
+#include "2a_life_grid.h"
+
+#include <bit>
+#include <cstring>
+
+namespace {
+
+// stands in for the cells of a missing neighbour
+constexpr uint64_t no_cells[64]{};
+
+} // namespace
+
+// a new tile is linked to the neighbours which already exist, and they to it
+tiled_life::tile &tiled_life::find_or_create(int32_t tx, int32_t ty) {
+  auto [it, created] = tiles.try_emplace(key(tx, ty));
+  tile &t = it->second;
+  if (created) {
+    t.tx = tx;
+    t.ty = ty;
+    t.around[1][1] = &t;
+    for (int dy = -1; dy <= 1; ++dy) {
+      for (int dx = -1; dx <= 1; ++dx) {
+        if (dx == 0 && dy == 0) {
+          continue;
+        }
+        auto n = tiles.find(key(tx + dx, ty + dy));
+        if (n != tiles.end()) {
+          t.around[dy + 1][dx + 1] = &n->second;
+          n->second.around[1 - dy][1 - dx] = &t;
+        }
+      }
+    }
+  }
+  return t;
+}
+
+void tiled_life::remove(tile &t) {
+  for (int dy = -1; dy <= 1; ++dy) {
+    for (int dx = -1; dx <= 1; ++dx) {
+      if ((dx != 0 || dy != 0) && t.around[dy + 1][dx + 1]) {
+        t.around[dy + 1][dx + 1]->around[1 - dy][1 - dx] = nullptr;
+      }
+    }
+  }
+  tiles.erase(key(t.tx, t.ty));
+}
+
+// floor division, so that x = -1 is in tile -1
+void tiled_life::set(int64_t x, int64_t y, bool alive) {
+  tile &t = find_or_create(static_cast<int32_t>(x >> 6),
+                           static_cast<int32_t>(y >> 6));
+  uint64_t bit = uint64_t{1} << (x & 63);
+  if (alive) {
+    t.cells[y & 63] |= bit;
+  } else {
+    t.cells[y & 63] &= ~bit;
+  }
+  if (!t.changed) {
+    t.changed = true;
+    changed.push_back(&t);
+  }
+}
+
+bool tiled_life::get(int64_t x, int64_t y) const {
+  auto it = tiles.find(
+      key(static_cast<int32_t>(x >> 6), static_cast<int32_t>(y >> 6)));
+  if (it == tiles.end()) {
+    return false;
+  }
+  return it->second.cells[y & 63] >> (x & 63) & 1;
+}
+
+size_t tiled_life::population() const {
+  size_t n = 0;
+  for (const auto &[k, t] : tiles) {
+    for (uint64_t w : t.cells) {
+      n += std::popcount(w);
+    }
+  }
+  return n;
+}
+
+// the next generation of tile t into t.next
+// the tile's rows and the edges of its neighbours are laid out as 66 rows of
+// three words, west, here and east, which is what next_word expects
+void tiled_life::compute(tile &t) {
+  const uint64_t *cells[3][3];
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      cells[i][j] = t.around[i][j] ? t.around[i][j]->cells : no_cells;
+    }
+  }
+
+  uint64_t rows[tile_size + 2][3];
+  for (int i = 0; i < 3; ++i) {
+    rows[0][i] = cells[0][i][tile_size - 1];
+    rows[tile_size + 1][i] = cells[2][i][0];
+  }
+  for (int y = 0; y < tile_size; ++y) {
+    rows[y + 1][0] = cells[1][0][y];
+    rows[y + 1][1] = cells[1][1][y];
+    rows[y + 1][2] = cells[1][2][y];
+  }
+  for (int y = 0; y < tile_size; ++y) {
+    t.next[y] = next_word(rows[y] + 1, rows[y + 1] + 1, rows[y + 2] + 1);
+  }
+}
+
+void tiled_life::step() {
+  // create the neighbours which could have cells born in them
+  for (tile *t : changed) {
+    uint64_t top = t->cells[0];
+    uint64_t bottom = t->cells[tile_size - 1];
+    uint64_t left = 0;
+    uint64_t right = 0;
+    for (uint64_t w : t->cells) {
+      left |= w & 1;
+      right |= w >> 63;
+    }
+    bool edge[3][3] = {
+        {(top & 1) != 0, top != 0, (top >> 63) != 0},
+        {left != 0, false, right != 0},
+        {(bottom & 1) != 0, bottom != 0, (bottom >> 63) != 0},
+    };
+    for (int i = 0; i < 3; ++i) {
+      for (int j = 0; j < 3; ++j) {
+        if (edge[i][j] && !t->around[i][j]) {
+          find_or_create(t->tx + j - 1, t->ty + i - 1);
+        }
+      }
+    }
+  }
+
+  // the changed tiles and every neighbour which exists
+  active.clear();
+  for (tile *t : changed) {
+    for (auto &row : t->around) {
+      for (tile *n : row) {
+        if (n && !n->active) {
+          n->active = true;
+          active.push_back(n);
+        }
+      }
+    }
+  }
+
+  for (tile *t : active) {
+    compute(*t);
+  }
+
+  // every changed tile is also active, so this resets all the flags
+  changed.clear();
+  std::vector<tile *> dropped;
+  for (tile *t : active) {
+    t->active = false;
+    t->changed = std::memcmp(t->cells, t->next, sizeof(t->cells)) != 0;
+    std::memcpy(t->cells, t->next, sizeof(t->cells));
+    if (t->changed) {
+      changed.push_back(t);
+      continue;
+    }
+    uint64_t any = 0;
+    for (uint64_t w : t->cells) {
+      any |= w;
+    }
+    if (any == 0) {
+      dropped.push_back(t);
+    }
+  }
+  for (tile *t : dropped) {
+    remove(*t);
+  }
+  ++generation;
+}
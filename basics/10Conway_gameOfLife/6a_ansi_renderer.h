@@ -0,0 +1,52 @@
+#ifndef ANSI_RENDERER_H
+#define ANSI_RENDERER_H
+
+#include "2a_life_grid.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+Terminal display of a life_grid with ANSI escape codes
+- 1Conway_gameOfLife.cpp clears the screen and prints every cell through
+  std::cout, with a colour escape and a reset around every live cell
+- This renderer remembers what is on the screen and only sends the cells
+  which are different from the last frame
+  * The cursor is only moved when the next changed cell isn't where it
+    already is. A move along the same row is the short "forward n" escape
+    \x1b[nC, anything else is \x1b[row;colH
+  * Dead cells are spaces, which look the same in any colour, so the colour
+    is only switched to green before the first live cell of a frame and
+    reset once at the end
+- The frame is put together in a buffer which is allocated once, big enough
+  for the worst case, and sent with a single write() per frame
+- The first frame clears the screen and draws everything
+*/
+class ansi_renderer {
+
+private:
+  int width;
+  int height;
+  int fd;
+  std::vector<uint8_t> shown; // what is on the screen, one byte per cell
+  std::vector<char> buffer;
+  bool first_frame{true};
+  size_t bytes{0};
+
+public:
+  // shows the top left width x height cells of the grid, on terminal rows
+  // 1 to height. throws std::invalid_argument if either is less than 1
+  ansi_renderer(int width, int height, int fd = 1);
+
+  // throws std::system_error if the write fails
+  void draw(const life_grid &grid);
+
+  // makes the next frame a full redraw, e.g. after something else has
+  // written to the terminal
+  void invalidate() { first_frame = true; }
+
+  size_t bytes_written() const { return bytes; }
+};
+
+#endif // ANSI_RENDERER_H
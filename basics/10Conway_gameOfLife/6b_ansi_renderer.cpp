@@ -0,0 +1,111 @@
+#include "6a_ansi_renderer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <unistd.h>
+
+namespace {
+
+// the longest cursor move is "\x1b[" + 5 digits + ";" + 5 digits + "H"
+constexpr size_t max_move = 14;
+
+char *put(char *out, const char *text) {
+  size_t n = std::strlen(text);
+  std::memcpy(out, text, n);
+  return out + n;
+}
+
+char *put_number(char *out, int n) {
+  return std::to_chars(out, out + 5, n).ptr;
+}
+
+} // namespace
+
+ansi_renderer::ansi_renderer(int width, int height, int fd)
+    : width(width), height(height), fd(fd) {
+  if (width < 1 || height < 1 || width > 99999 || height > 99999) {
+    throw std::invalid_argument("screen dimensions must be 1 to 99999");
+  }
+  shown.assign(static_cast<size_t>(width) * height, 0);
+  // every cell changed, each needing a move, plus room for the clear, the
+  // colour change, the reset and the final move
+  buffer.resize(static_cast<size_t>(width) * height * (max_move + 1) + 64);
+}
+
+void ansi_renderer::draw(const life_grid &grid) {
+  int w = std::min(width, grid.get_width());
+  int h = std::min(height, grid.get_height());
+  char *out = buffer.data();
+
+  if (first_frame) {
+    out = put(out, "\x1b[H\x1b[2J");
+    std::fill(shown.begin(), shown.end(), 0); // the screen is blank now
+  }
+
+  // where the terminal cursor is, 0 based, or -1 if not known
+  int cursor_x = first_frame ? 0 : -1;
+  int cursor_y = first_frame ? 0 : -1;
+  bool green = false;
+
+  for (int y = 0; y < h; ++y) {
+    const uint64_t *row = grid.row(y);
+    uint8_t *on_screen = shown.data() + static_cast<size_t>(y) * width;
+    for (int x = 0; x < w; ++x) {
+      uint8_t alive = row[x / 64] >> (x % 64) & 1;
+      if (alive == on_screen[x]) {
+        continue;
+      }
+      on_screen[x] = alive;
+
+      if (y != cursor_y || x < cursor_x) {
+        out = put(out, "\x1b[");
+        out = put_number(out, y + 1);
+        *out++ = ';';
+        out = put_number(out, x + 1);
+        *out++ = 'H';
+      } else if (x > cursor_x) {
+        out = put(out, "\x1b[");
+        out = put_number(out, x - cursor_x);
+        *out++ = 'C';
+      }
+
+      if (alive && !green) {
+        out = put(out, "\x1b[32m");
+        green = true;
+      }
+      *out++ = alive ? '+' : ' ';
+      // the cursor stays on the last column after writing there
+      cursor_x = x + 1;
+      cursor_y = y;
+    }
+  }
+
+  if (green) {
+    out = put(out, "\x1b[0m");
+  }
+  // park the cursor under the grid, if anything was drawn
+  if (cursor_y >= 0) {
+    out = put(out, "\x1b[");
+    out = put_number(out, height + 1);
+    out = put(out, ";1H");
+  }
+  first_frame = false;
+
+  const char *p = buffer.data();
+  while (p < out) {
+    ssize_t n = ::write(fd, p, out - p);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::system_error(errno, std::generic_category(),
+                              "writing a frame");
+    }
+    p += n;
+    bytes += n;
+  }
+}
@@ -0,0 +1,139 @@
+/*
+Diff-based ANSI renderer vs. printing every cell through std::cout
+- The cout version is the drawing loop from 1Conway_gameOfLife.cpp: clear
+  the screen, then every cell, with a colour escape and a reset around each
+  live one
+- Both draw the same sequence of generations of a random board, at the
+  original 79x23 and at a bigger 200x60 terminal size
+- The frames go to /dev/null, so the times are what it costs the program to
+  produce them. A real terminal also has to parse every byte, which is where
+  the smaller frames help the most
+- The cout version makes one write() per line on a terminal, or per buffer
+  full otherwise. The renderer always makes one write() per frame
+- Run with "show" to watch the renderer in the terminal
+
+build: g++ -std=c++20 -O3 -march=native 2b_life_grid.cpp 6b_ansi_renderer.cpp
+       6c_ansi_renderer_main.cpp
+*/
+
+#include "6a_ansi_renderer.h"
+
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+using namespace std::chrono;
+
+void draw_with_cout(ostream &out, const life_grid &grid) {
+  out << "\x1b[H\x1b[2J";
+  for (int i = 0; i < grid.get_height(); ++i) {
+    for (int j = 0; j < grid.get_width(); ++j) {
+      if (grid.get(j, i)) {
+        out << "\x1b[32m" << "+" << "\x1b[0m";
+      } else {
+        out << " ";
+      }
+    }
+    out << "\n";
+  }
+  out << flush;
+}
+
+life_grid random_board(int width, int height) {
+  mt19937_64 rng(3);
+  life_grid grid(width, height);
+  grid.randomize(rng);
+  return grid;
+}
+
+void compare(int width, int height, int frames) {
+  // the bytes each way, for the same frames
+  size_t cout_bytes = 0;
+  size_t renderer_bytes = 0;
+  {
+    int null = open("/dev/null", O_WRONLY);
+    life_grid grid = random_board(width, height);
+    ansi_renderer renderer(width, height, null);
+    for (int f = 0; f < frames; ++f) {
+      ostringstream frame;
+      draw_with_cout(frame, grid);
+      cout_bytes += frame.str().size();
+      renderer.draw(grid);
+      grid.step();
+    }
+    renderer_bytes = renderer.bytes_written();
+    close(null);
+  }
+
+  // the times, with stdout pointing at /dev/null
+  cout.flush();
+  int saved_stdout = dup(1);
+  int null = open("/dev/null", O_WRONLY);
+  dup2(null, 1);
+
+  life_grid grid = random_board(width, height);
+  auto start = steady_clock::now();
+  for (int f = 0; f < frames; ++f) {
+    draw_with_cout(cout, grid);
+    grid.step();
+  }
+  duration<double> cout_time = steady_clock::now() - start;
+
+  grid = random_board(width, height);
+  ansi_renderer renderer(width, height, 1);
+  start = steady_clock::now();
+  for (int f = 0; f < frames; ++f) {
+    renderer.draw(grid);
+    grid.step();
+  }
+  duration<double> renderer_time = steady_clock::now() - start;
+
+  dup2(saved_stdout, 1);
+  close(saved_stdout);
+  close(null);
+
+  // the stepping is in both times, but costs far less than the drawing
+  auto per_frame_us = [frames](duration<double> d) {
+    return d.count() * 1e6 / frames;
+  };
+  cout << width << "x" << height << ", " << frames << " frames\n";
+  cout << setw(12) << "" << setw(14) << "bytes/frame" << setw(14)
+       << "us/frame" << "\n";
+  cout << fixed << setprecision(1);
+  cout << setw(12) << "cout" << setw(14)
+       << static_cast<double>(cout_bytes) / frames << setw(14)
+       << per_frame_us(cout_time) << "\n";
+  cout << setw(12) << "renderer" << setw(14)
+       << static_cast<double>(renderer_bytes) / frames << setw(14)
+       << per_frame_us(renderer_time) << "\n";
+  cout << setw(12) << "ratio" << setw(14)
+       << static_cast<double>(cout_bytes) / renderer_bytes << setw(14)
+       << cout_time / renderer_time << "\n\n"
+       << defaultfloat;
+}
+
+void show() {
+  life_grid grid = random_board(79, 23);
+  ansi_renderer renderer(79, 23);
+  for (int f = 0; f < 300; ++f) {
+    renderer.draw(grid);
+    grid.step();
+    this_thread::sleep_for(milliseconds(50));
+  }
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && strcmp(argv[1], "show") == 0) {
+    show();
+    return 0;
+  }
+  compare(79, 23, 5000);
+  compare(200, 60, 2000);
+}
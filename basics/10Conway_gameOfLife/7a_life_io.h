@@ -0,0 +1,100 @@
+#ifndef LIFE_IO_H
+#define LIFE_IO_H
+
+#include "2a_life_grid.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*
+Loading and saving life_grid boards
+- RLE is the usual text format for Life patterns:
+    #C comment lines
+    x = 3, y = 3, rule = B3/S23
+    bo$2bo$3o!
+  b is a dead cell, o a live one, $ the end of a row and ! the end of the
+  pattern. Any of them can have a repeat count in front, and dead cells at
+  the end of a row are left out
+- A snapshot is the grid's own bit-packed rows, after a 64 byte header, so a
+  board can be checkpointed and resumed at the speed of the disk
+  * The header has the size, the generation and a checksum of the cells
+  * The rows are packed with no guard words, starting 64 bytes into the file,
+    so a mapped snapshot can be read in place as uint64_t words
+  * Numbers are stored little-endian, the same as in memory on x86 and ARM
+  * A snapshot is written to a temporary file, flushed to disk and renamed
+    over the old one, so a crash part way through never leaves a broken
+    checkpoint behind
+- Everything throws std::runtime_error when a file can't be read or written,
+  or is not a valid pattern or snapshot
+*/
+
+// the pattern in text, in a grid margin cells bigger than the pattern on
+// every side, with the pattern's top left cell at (margin, margin)
+life_grid read_rle(std::string_view text, int margin = 0);
+life_grid load_rle(const std::string &filename, int margin = 0);
+
+std::string write_rle(const life_grid &grid);
+void save_rle(const std::string &filename, const life_grid &grid);
+
+struct snapshot_header {
+  char magic[8]; // "LIFESNAP"
+  uint32_t version;
+  uint32_t width;
+  uint32_t height;
+  uint32_t words_per_row;
+  uint64_t generation;
+  uint64_t checksum; // of all the cell words, in order
+  uint8_t unused[24];
+};
+static_assert(sizeof(snapshot_header) == 64);
+
+void save_snapshot(const std::string &filename, const life_grid &grid,
+                   uint64_t generation = 0);
+
+// a snapshot file mapped read-only into memory
+// the header is checked when it is opened, and the cells when they are
+// copied into a grid or verify() is called
+class mapped_snapshot {
+
+private:
+  int fd{-1};
+  const uint8_t *map{nullptr};
+  size_t map_size{0};
+  snapshot_header header{};
+
+  void close();
+
+public:
+  explicit mapped_snapshot(const std::string &filename);
+  ~mapped_snapshot();
+
+  mapped_snapshot(const mapped_snapshot &) = delete;
+  mapped_snapshot &operator=(const mapped_snapshot &) = delete;
+
+  int get_width() const { return header.width; }
+  int get_height() const { return header.height; }
+  uint64_t get_generation() const { return header.generation; }
+  int words_per_row() const { return header.words_per_row; }
+
+  const uint64_t *row(int y) const {
+    return reinterpret_cast<const uint64_t *>(map + sizeof(header)) +
+           static_cast<size_t>(y) * header.words_per_row;
+  }
+
+  bool verify() const; // true if the checksum matches the cells
+
+  // copies the cells into grid, which must be the same size, checking the
+  // checksum on the way
+  void copy_to(life_grid &grid) const;
+};
+
+struct life_snapshot {
+  life_grid grid;
+  uint64_t generation;
+};
+
+life_snapshot load_snapshot(const std::string &filename);
+
+#endif // LIFE_IO_H
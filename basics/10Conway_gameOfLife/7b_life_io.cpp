@@ -0,0 +1,476 @@
+#include "7a_life_io.h"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+runtime_error io_error(const string &filename, const string &what) {
+  return runtime_error(filename + ": " + what);
+}
+
+// RLE lines are meant to be at most 70 characters
+constexpr size_t rle_line_length = 70;
+
+constexpr char snapshot_magic[8]{'L', 'I', 'F', 'E', 'S', 'N', 'A', 'P'};
+constexpr uint32_t snapshot_version = 1;
+
+// 4 independent lanes, so consecutive words don't wait on each other's
+// multiply. The rotate moves the high bits down before the multiply spreads
+// them upwards again, so a change anywhere in a word changes the result
+class checksum {
+  static constexpr uint64_t k = 0x9e3779b97f4a7c15;
+  uint64_t lanes[4]{1, 2, 3, 4};
+
+public:
+  void add(const uint64_t *words, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+      for (int j = 0; j < 4; ++j) {
+        lanes[j] = rotl(lanes[j] ^ words[i + j], 23) * k;
+      }
+    }
+    for (; i < n; ++i) {
+      lanes[0] = rotl(lanes[0] ^ words[i], 23) * k;
+    }
+  }
+
+  uint64_t value() const {
+    uint64_t h = lanes[0];
+    for (int j = 1; j < 4; ++j) {
+      h = rotl(h ^ lanes[j], 23) * k;
+    }
+    return h ^ (h >> 32);
+  }
+};
+
+// sets n cells from x onwards, a word at a time
+void set_run(uint64_t *row, int x, int n) {
+  while (n > 0) {
+    int bit = x % 64;
+    int take = min(64 - bit, n);
+    uint64_t mask = take == 64 ? ~uint64_t{0} : (uint64_t{1} << take) - 1;
+    row[x / 64] |= mask << bit;
+    x += take;
+    n -= take;
+  }
+}
+
+// the end of the run of alive (or dead) cells which starts at x
+int run_end(const uint64_t *row, int x, bool alive, int width) {
+  // the cells which are not part of the run become 1s
+  uint64_t flip = alive ? ~uint64_t{0} : 0;
+  int i = x / 64;
+  uint64_t w = (row[i] ^ flip) >> (x % 64);
+  if (w != 0) {
+    return min(x + countr_zero(w), width);
+  }
+  for (++i; i * 64 < width; ++i) {
+    w = row[i] ^ flip;
+    if (w != 0) {
+      return min(i * 64 + countr_zero(w), width);
+    }
+  }
+  return width;
+}
+
+string_view trim(string_view s) {
+  while (!s.empty() && isspace(static_cast<unsigned char>(s.front()))) {
+    s.remove_prefix(1);
+  }
+  while (!s.empty() && isspace(static_cast<unsigned char>(s.back()))) {
+    s.remove_suffix(1);
+  }
+  return s;
+}
+
+// the "x = 3, y = 3, rule = B3/S23" line
+void read_rle_header(string_view line, int &width, int &height) {
+  width = 0;
+  height = 0;
+  while (!line.empty()) {
+    size_t comma = line.find(',');
+    string_view field = line.substr(0, comma);
+    line = comma == string_view::npos ? string_view{}
+                                      : line.substr(comma + 1);
+
+    size_t equals = field.find('=');
+    if (equals == string_view::npos) {
+      throw runtime_error("bad RLE header field: " + string(field));
+    }
+    string_view key = trim(field.substr(0, equals));
+    string_view value = trim(field.substr(equals + 1));
+    if (key == "x" || key == "y") {
+      int n = 0;
+      const char *last = value.data() + value.size();
+      auto [end, ec] = from_chars(value.data(), last, n);
+      if (ec != errc{} || end != last) {
+        throw runtime_error("bad RLE pattern size: " + string(value));
+      }
+      (key == "x" ? width : height) = n;
+    } else if (key == "rule") {
+      string rule;
+      for (char c : value) {
+        rule += static_cast<char>(toupper(static_cast<unsigned char>(c)));
+      }
+      if (rule != "B3/S23" && rule != "23/3") {
+        throw runtime_error("only Conway's rule B3/S23 is supported, not " +
+                            string(value));
+      }
+    }
+  }
+  if (width < 1 || height < 1) {
+    throw runtime_error("RLE header has no pattern size");
+  }
+}
+
+string read_file(const string &filename) {
+  ifstream in(filename, ios::binary);
+  if (!in) {
+    throw runtime_error(strerror(errno));
+  }
+  in.seekg(0, ios::end);
+  string text(static_cast<size_t>(in.tellg()), '\0');
+  in.seekg(0);
+  in.read(text.data(), static_cast<streamsize>(text.size()));
+  if (!in) {
+    throw runtime_error("read failed");
+  }
+  return text;
+}
+
+// writev all of iov, at most IOV_MAX entries per call, carrying on after a
+// short write. The entries are updated to track progress
+bool write_all(int fd, iovec *iov, size_t count) {
+  while (count > 0) {
+    ssize_t n =
+        writev(fd, iov, static_cast<int>(min<size_t>(count, IOV_MAX)));
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    size_t done = n;
+    while (count > 0 && done >= iov->iov_len) {
+      done -= iov->iov_len;
+      ++iov;
+      --count;
+    }
+    if (count > 0) {
+      iov->iov_base = static_cast<uint8_t *>(iov->iov_base) + done;
+      iov->iov_len -= done;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+life_grid read_rle(string_view text, int margin) {
+  // skip the comment lines, the first other line is the header
+  size_t line_end = 0;
+  string_view header;
+  while (true) {
+    line_end = text.find('\n');
+    string_view line = trim(text.substr(0, line_end));
+    text = line_end == string_view::npos ? string_view{}
+                                         : text.substr(line_end + 1);
+    if (!line.empty() && line[0] != '#') {
+      header = line;
+      break;
+    }
+    if (text.empty()) {
+      throw runtime_error("RLE pattern has no header");
+    }
+  }
+
+  int width;
+  int height;
+  read_rle_header(header, width, height);
+  if (margin < 0 || width > life_grid::max_dimension - 2 * margin ||
+      height > life_grid::max_dimension - 2 * margin) {
+    throw runtime_error("RLE pattern is too big for a life_grid");
+  }
+  life_grid grid(width + 2 * margin, height + 2 * margin);
+
+  int x = 0;
+  int y = 0;
+  int count = 0;
+  for (char c : text) {
+    if (c >= '0' && c <= '9') {
+      count = count * 10 + (c - '0');
+      if (count > life_grid::max_dimension) {
+        throw runtime_error("RLE run is too long");
+      }
+      continue;
+    }
+    if (isspace(static_cast<unsigned char>(c))) {
+      continue;
+    }
+    int n = count == 0 ? 1 : count;
+    count = 0;
+    // runs past the edge are clamped, so a following live cell is caught
+    if (c == 'b') {
+      x = min(x + n, width);
+    } else if (c == 'o') {
+      if (x + n > width || y >= height) {
+        throw runtime_error("RLE pattern is bigger than its header says");
+      }
+      set_run(grid.row(y + margin), x + margin, n);
+      x += n;
+    } else if (c == '$') {
+      y = min(y + n, height);
+      x = 0;
+    } else if (c == '!') {
+      break;
+    } else {
+      throw runtime_error(string("unexpected '") + c + "' in RLE pattern");
+    }
+  }
+  return grid;
+}
+
+life_grid load_rle(const string &filename, int margin) {
+  try {
+    return read_rle(read_file(filename), margin);
+  } catch (const runtime_error &e) {
+    throw io_error(filename, e.what());
+  }
+}
+
+string write_rle(const life_grid &grid) {
+  int width = grid.get_width();
+  string out = "x = " + to_string(width) +
+               ", y = " + to_string(grid.get_height()) + ", rule = B3/S23\n";
+  size_t line = 0;
+  auto emit = [&](int n, char c) {
+    char item[16];
+    char *end = item;
+    if (n > 1) {
+      end = to_chars(item, item + sizeof(item), n).ptr;
+    }
+    *end++ = c;
+    size_t length = end - item;
+    if (line + length > rle_line_length) {
+      out += '\n';
+      line = 0;
+    }
+    out.append(item, length);
+    line += length;
+  };
+
+  // rows with nothing alive are just more $s before the next live cell,
+  // and the dead cells at the end of a row are left out
+  int rows_pending = 0;
+  for (int y = 0; y < grid.get_height(); ++y) {
+    const uint64_t *row = grid.row(y);
+    int dead_from = 0;
+    int x = 0;
+    while (x < width) {
+      bool alive = row[x / 64] >> (x % 64) & 1;
+      int end = run_end(row, x, alive, width);
+      if (alive) {
+        if (rows_pending > 0) {
+          emit(rows_pending, '$');
+          rows_pending = 0;
+        }
+        if (x > dead_from) {
+          emit(x - dead_from, 'b');
+        }
+        emit(end - x, 'o');
+        dead_from = end;
+      }
+      x = end;
+    }
+    ++rows_pending;
+  }
+  out += "!\n";
+  return out;
+}
+
+void save_rle(const string &filename, const life_grid &grid) {
+  string text = write_rle(grid);
+  ofstream out(filename, ios::binary);
+  out.write(text.data(), static_cast<streamsize>(text.size()));
+  if (!out) {
+    throw io_error(filename, "write failed");
+  }
+}
+
+void save_snapshot(const string &filename, const life_grid &grid,
+                   uint64_t generation) {
+  snapshot_header header{};
+  memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+  header.version = snapshot_version;
+  header.width = grid.get_width();
+  header.height = grid.get_height();
+  header.words_per_row = grid.words_per_row();
+  header.generation = generation;
+
+  string temporary = filename + ".tmp";
+  int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    throw io_error(temporary, strerror(errno));
+  }
+  auto fail = [&](int err) {
+    ::close(fd);
+    ::unlink(temporary.c_str());
+    return io_error(temporary, strerror(err));
+  };
+
+  // the header goes in last, once the checksum is known
+  iovec header_iov{&header, sizeof(header)};
+  if (!write_all(fd, &header_iov, 1)) {
+    throw fail(errno);
+  }
+
+  // the rows are separated by guard words in memory, so each one is an
+  // iovec, IOV_MAX at a time, checksummed just before they are written
+  checksum sum;
+  size_t row_bytes = header.words_per_row * sizeof(uint64_t);
+  vector<iovec> rows(min<size_t>(header.height, IOV_MAX));
+  for (int y0 = 0; y0 < grid.get_height();) {
+    int n = min<int>(rows.size(), grid.get_height() - y0);
+    for (int i = 0; i < n; ++i) {
+      const uint64_t *row = grid.row(y0 + i);
+      sum.add(row, header.words_per_row);
+      rows[i] = {const_cast<uint64_t *>(row), row_bytes};
+    }
+    if (!write_all(fd, rows.data(), n)) {
+      throw fail(errno);
+    }
+    y0 += n;
+  }
+
+  header.checksum = sum.value();
+  if (pwrite(fd, &header, sizeof(header), 0) !=
+          static_cast<ssize_t>(sizeof(header)) ||
+      fdatasync(fd) != 0) {
+    throw fail(errno);
+  }
+  if (::close(fd) != 0 || rename(temporary.c_str(), filename.c_str()) != 0) {
+    int err = errno;
+    ::unlink(temporary.c_str());
+    throw io_error(filename, strerror(err));
+  }
+}
+
+mapped_snapshot::mapped_snapshot(const string &filename) {
+  fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw io_error(filename, strerror(errno));
+  }
+
+  struct stat st {};
+  if (fstat(fd, &st) != 0) {
+    int err = errno;
+    close();
+    throw io_error(filename, strerror(err));
+  }
+  map_size = st.st_size;
+  if (map_size < sizeof(header)) {
+    close();
+    throw io_error(filename, "too small to be a snapshot");
+  }
+
+  void *addr = mmap(nullptr, map_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED) {
+    int err = errno;
+    map_size = 0;
+    close();
+    throw io_error(filename, strerror(err));
+  }
+  map = static_cast<const uint8_t *>(addr);
+  madvise(addr, map_size, MADV_SEQUENTIAL);
+  memcpy(&header, map, sizeof(header));
+
+  const char *problem = nullptr;
+  if (memcmp(header.magic, snapshot_magic, sizeof(header.magic)) != 0) {
+    problem = "not a snapshot";
+  } else if (header.version != snapshot_version) {
+    problem = "unsupported snapshot version";
+  } else if (header.width < 1 || header.height < 1 ||
+             header.width > uint32_t{life_grid::max_dimension} ||
+             header.height > uint32_t{life_grid::max_dimension} ||
+             header.words_per_row != (header.width + 63) / 64) {
+    problem = "bad board dimensions";
+  } else if (map_size != sizeof(header) + size_t{header.words_per_row} *
+                                              header.height *
+                                              sizeof(uint64_t)) {
+    problem = "file size doesn't match the board";
+  }
+  if (problem) {
+    close();
+    throw io_error(filename, problem);
+  }
+}
+
+mapped_snapshot::~mapped_snapshot() { close(); }
+
+void mapped_snapshot::close() {
+  if (map) {
+    munmap(const_cast<uint8_t *>(map), map_size);
+    map = nullptr;
+  }
+  if (fd >= 0) {
+    ::close(fd);
+    fd = -1;
+  }
+}
+
+bool mapped_snapshot::verify() const {
+  // a row at a time, as save_snapshot() added them, since the words left
+  // over from each row go into the first lane
+  checksum sum;
+  for (int y = 0; y < get_height(); ++y) {
+    sum.add(row(y), header.words_per_row);
+  }
+  return sum.value() == header.checksum;
+}
+
+void mapped_snapshot::copy_to(life_grid &grid) const {
+  if (grid.get_width() != get_width() || grid.get_height() != get_height()) {
+    throw runtime_error("snapshot and grid are different sizes");
+  }
+  int words = header.words_per_row;
+  int spare = words * 64 - get_width();
+  checksum sum;
+  for (int y = 0; y < get_height(); ++y) {
+    uint64_t *to = grid.row(y);
+    memcpy(to, row(y), words * sizeof(uint64_t));
+    sum.add(to, words);
+    // cells past the right hand edge must stay dead
+    to[words - 1] &= ~uint64_t{0} >> spare;
+  }
+  if (sum.value() != header.checksum) {
+    throw runtime_error("snapshot checksum doesn't match, the file is "
+                        "damaged");
+  }
+}
+
+life_snapshot load_snapshot(const string &filename) {
+  mapped_snapshot snapshot(filename);
+  life_grid grid(snapshot.get_width(), snapshot.get_height());
+  try {
+    snapshot.copy_to(grid);
+  } catch (const runtime_error &e) {
+    throw io_error(filename, e.what());
+  }
+  return {std::move(grid), snapshot.get_generation()};
+}
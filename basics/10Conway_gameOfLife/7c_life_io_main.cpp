@@ -0,0 +1,182 @@
+/*
+Loading and saving boards
+- Checks: the Gosper glider gun loads from RLE, a random board survives
+  RLE and snapshot round trips, mapped snapshots of widths which aren't a
+  multiple of 256 verify, and a damaged snapshot is refused
+- Then a 32768x32768 board, just over a billion cells with about a quarter
+  of them alive, is saved and loaded both ways
+  * Snapshot saves include flushing the file to disk, which is what makes
+    them safe as checkpoints
+  * "mapped + verify" is opening a snapshot in place and checking its
+    checksum, without copying it into a grid
+- The files go in the system temporary directory and are removed afterwards
+
+build: g++ -std=c++20 -O3 -march=native 2b_life_grid.cpp 7b_life_io.cpp
+       7c_life_io_main.cpp
+*/
+
+#include "7a_life_io.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <stdexcept>
+
+using namespace std;
+using namespace std::chrono;
+
+const char *gosper_gun = R"(#N Gosper glider gun
+#C The first known gun and the first known finite pattern with unbounded
+#C growth.
+x = 36, y = 9, rule = B3/S23
+24bo11b$22bobo11b$12b2o6b2o12b2o$11bo3bo4b2o12b2o$2o8bo5bo3b2o14b$2o8b
+o3bob2o4bobo11b$10bo5bo7bo11b$11bo3bo20b$12b2o!
+)";
+
+bool same_cells(const life_grid &a, const life_grid &b) {
+  if (a.get_width() != b.get_width() || a.get_height() != b.get_height()) {
+    return false;
+  }
+  for (int y = 0; y < a.get_height(); ++y) {
+    if (memcmp(a.row(y), b.row(y), a.words_per_row() * sizeof(uint64_t)) !=
+        0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// about a quarter of the cells alive, a word at a time so that a billion
+// cells doesn't take long to make
+life_grid random_board(int width, int height, uint64_t seed) {
+  mt19937_64 rng(seed);
+  life_grid grid(width, height);
+  int spare = grid.words_per_row() * 64 - width;
+  for (int y = 0; y < height; ++y) {
+    uint64_t *row = grid.row(y);
+    for (int i = 0; i < grid.words_per_row(); ++i) {
+      row[i] = rng() & rng();
+    }
+    row[grid.words_per_row() - 1] &= ~uint64_t{0} >> spare;
+  }
+  return grid;
+}
+
+bool checks(const filesystem::path &dir) {
+  bool ok = true;
+  auto check = [&ok](const char *what, bool passed) {
+    cout << setw(44) << left << what << (passed ? "yes" : "NO") << right
+         << "\n";
+    ok = ok && passed;
+  };
+
+  life_grid gun = read_rle(gosper_gun, 10);
+  // the gun has 36 cells, and makes a glider every 30 generations
+  size_t start = gun.population();
+  for (int g = 0; g < 30; ++g) {
+    gun.step();
+  }
+  check("gosper gun loads with 36 cells", start == 36);
+  check("and has grown a glider 30 generations later",
+        gun.population() == 36 + 5);
+
+  life_grid board = random_board(1000, 777, 1);
+  check("random board survives write_rle/read_rle",
+        same_cells(board, read_rle(write_rle(board))));
+
+  string file = (dir / "life_io_check.snap").string();
+  save_snapshot(file, board, 1234);
+  life_snapshot loaded = load_snapshot(file);
+  check("random board survives a snapshot",
+        same_cells(board, loaded.grid) && loaded.generation == 1234);
+  // 1000 wide is 16 words a row, so also try widths whose rows don't split
+  // evenly into the checksum's 4 lanes
+  bool verified = mapped_snapshot(file).verify();
+  for (int width : {64, 100, 300}) {
+    string odd = (dir / "life_io_check_odd.snap").string();
+    save_snapshot(odd, random_board(width, 50, width), 1);
+    verified = verified && mapped_snapshot(odd).verify();
+    filesystem::remove(odd);
+  }
+  check("mapped snapshots verify at odd widths", verified);
+
+  // change one cell in the middle of the file
+  {
+    fstream f(file, ios::in | ios::out | ios::binary);
+    f.seekp(64 + 50 * board.words_per_row() * 8 + 3);
+    char c;
+    f.read(&c, 1);
+    c ^= 0x10;
+    f.seekp(64 + 50 * board.words_per_row() * 8 + 3);
+    f.write(&c, 1);
+  }
+  bool refused = false;
+  try {
+    load_snapshot(file);
+  } catch (const runtime_error &) {
+    refused = true;
+  }
+  check("damaged snapshot is refused", refused);
+  filesystem::remove(file);
+  cout << "\n";
+  return ok;
+}
+
+template <typename F> double time_it(F f) {
+  auto start = steady_clock::now();
+  f();
+  return duration<double>(steady_clock::now() - start).count();
+}
+
+int main() {
+  filesystem::path dir = filesystem::temp_directory_path();
+  if (!checks(dir)) {
+    return 1;
+  }
+
+  const int size = 32768;
+  life_grid board = random_board(size, size, 2);
+  string snap = (dir / "life_io_bench.snap").string();
+  string rle = (dir / "life_io_bench.rle").string();
+  cout << size << "x" << size << ", " << board.population()
+       << " cells alive\n";
+  cout << setw(18) << "" << setw(12) << "seconds" << setw(12) << "MB"
+       << setw(12) << "MB/s" << "\n";
+
+  auto report = [](const char *what, double s, const string &file) {
+    double mb = filesystem::file_size(file) / 1e6;
+    cout << setw(18) << what << fixed << setprecision(3) << setw(12) << s
+         << setprecision(1) << setw(12) << mb << setw(12) << mb / s
+         << defaultfloat << "\n";
+  };
+
+  report("save snapshot", time_it([&] { save_snapshot(snap, board, 1); }),
+         snap);
+  // the loads are timed on their own, and compared afterwards
+  optional<life_snapshot> loaded;
+  report("load snapshot",
+         time_it([&] { loaded.emplace(load_snapshot(snap)); }), snap);
+  bool same = same_cells(board, loaded->grid);
+  loaded.reset();
+  bool verified = false;
+  report("mapped + verify", time_it([&] {
+           mapped_snapshot mapped(snap);
+           verified = mapped.verify();
+         }),
+         snap);
+  report("save RLE", time_it([&] { save_rle(rle, board); }), rle);
+  optional<life_grid> loaded_rle;
+  report("load RLE", time_it([&] { loaded_rle.emplace(load_rle(rle)); }),
+         rle);
+  bool same_rle = same_cells(board, *loaded_rle);
+
+  cout << "loaded boards match: "
+       << (same && verified && same_rle ? "yes" : "NO") << "\n";
+  filesystem::remove(snap);
+  filesystem::remove(rle);
+}
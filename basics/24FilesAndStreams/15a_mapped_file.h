@@ -0,0 +1,82 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+A whole file mapped read-only into memory
+- The file's bytes are read straight from the page cache, with no copying
+  into a stream buffer and no std::string per line
+- text() is the whole file as a string_view, which stays valid as long as
+  the mapped_file does
+- The kernel is told the file will be read from start to end, so it reads
+  ahead
+- Throws std::runtime_error if the file can't be opened or mapped
+- An empty file is fine, and gives an empty text()
+*/
+
+class mapped_file {
+  int fd{-1};
+  const char *map{nullptr};
+  size_t map_size{0};
+
+  static std::runtime_error io_error(const std::string &filename, int err) {
+    return std::runtime_error(filename + ": " + std::strerror(err));
+  }
+
+  void close() {
+    if (map) {
+      munmap(const_cast<char *>(map), map_size);
+      map = nullptr;
+    }
+    if (fd >= 0) {
+      ::close(fd);
+      fd = -1;
+    }
+  }
+
+public:
+  explicit mapped_file(const std::string &filename) {
+    fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw io_error(filename, errno);
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0) {
+      int err = errno;
+      close();
+      throw io_error(filename, err);
+    }
+    map_size = static_cast<size_t>(st.st_size);
+    if (map_size == 0) {
+      return; // mmap can't map nothing
+    }
+    void *addr = mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      int err = errno;
+      map_size = 0;
+      close();
+      throw io_error(filename, err);
+    }
+    map = static_cast<const char *>(addr);
+    madvise(addr, map_size, MADV_SEQUENTIAL);
+  }
+  ~mapped_file() { close(); }
+
+  mapped_file(const mapped_file &) = delete;
+  mapped_file &operator=(const mapped_file &) = delete;
+
+  std::string_view text() const { return {map, map_size}; }
+  size_t size() const { return map_size; }
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,58 @@
+#ifndef LANGUAGE_PARSER_H
+#define LANGUAGE_PARSER_H
+
+#include "15a_mapped_file.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+Reading languages.txt and languages2.txt without a string per line
+- 10assignment.cpp, 11assignment.cpp and 11assignment_other.cpp read each
+  line into a std::string, copy it into an istringstream, read the words
+  out into more strings, and convert the year with stoi. That is several
+  heap allocations and a trip through the stream's locale for every line
+- Here the file is mapped into memory, and a record is three string_views
+  into the mapped bytes plus the year
+  * The name is the first word on the line and the year is the last
+  * The designer is everything in between, which may be several words, as
+    in languages2.txt. The spaces between its words are kept as they are
+  * The year is converted with std::from_chars, which doesn't look at the
+    locale and can't allocate
+- Parsing a whole file makes no allocations apart from the vector of
+  records, and that is sized up front by counting the lines
+- language_view only lives as long as the text it points into. to_language()
+  copies a record into the lessons' language struct, with its own strings
+- A line which isn't "name designer year" is an error, reported with its
+  line number. Blank lines are skipped, and a \r before the \n is ignored
+*/
+
+struct language {
+  std::string lang;
+  std::string designer;
+  int date;
+};
+
+struct language_view {
+  std::string_view lang;
+  std::string_view designer;
+  int date;
+};
+
+// false if line isn't a language record
+bool parse_language(std::string_view line, language_view &record);
+
+// every record in text, in order
+// throws std::runtime_error for a line which isn't a record
+std::vector<language_view> parse_languages(std::string_view text);
+
+inline language to_language(const language_view &record) {
+  return {std::string(record.lang), std::string(record.designer),
+          record.date};
+}
+
+// the whole file, as language structs
+std::vector<language> load_languages(const std::string &filename);
+
+#endif // LANGUAGE_PARSER_H
@@ -0,0 +1,98 @@
+#include "15b_language_parser.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+bool is_space(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+string_view trim(string_view s) {
+  size_t begin = 0;
+  while (begin < s.size() && is_space(s[begin])) {
+    ++begin;
+  }
+  size_t end = s.size();
+  while (end > begin && is_space(s[end - 1])) {
+    --end;
+  }
+  return s.substr(begin, end - begin);
+}
+
+} // namespace
+
+bool parse_language(string_view line, language_view &record) {
+  line = trim(line);
+  auto first_space = find_if(line.begin(), line.end(), is_space);
+  auto last_space = find_if(line.rbegin(), line.rend(), is_space).base();
+  if (first_space == line.end() || last_space <= first_space) {
+    return false; // fewer than three words
+  }
+
+  string_view designer = trim(string_view(first_space, last_space));
+  if (designer.empty()) {
+    return false;
+  }
+
+  const char *year = line.data() + (last_space - line.begin());
+  const char *end = line.data() + line.size();
+  int date;
+  auto [ptr, ec] = from_chars(year, end, date);
+  if (ec != errc{} || ptr != end) {
+    return false;
+  }
+
+  record.lang = string_view(line.begin(), first_space);
+  record.designer = designer;
+  record.date = date;
+  return true;
+}
+
+vector<language_view> parse_languages(string_view text) {
+  vector<language_view> records;
+  records.reserve(static_cast<size_t>(count(text.begin(), text.end(), '\n')) +
+                  1);
+
+  const char *p = text.data();
+  const char *end = p + text.size();
+  size_t line_number = 0;
+  while (p < end) {
+    ++line_number;
+    auto newline = static_cast<const char *>(
+        memchr(p, '\n', static_cast<size_t>(end - p)));
+    const char *line_end = newline ? newline : end;
+    string_view line(p, static_cast<size_t>(line_end - p));
+    p = newline ? newline + 1 : end;
+
+    language_view record;
+    if (parse_language(line, record)) {
+      records.push_back(record);
+    } else if (!trim(line).empty()) {
+      throw runtime_error("line " + to_string(line_number) +
+                          ": not a language record");
+    }
+  }
+  return records;
+}
+
+vector<language> load_languages(const string &filename) {
+  mapped_file file(filename);
+  vector<language_view> views;
+  try {
+    views = parse_languages(file.text());
+  } catch (const runtime_error &e) {
+    throw runtime_error(filename + ": " + e.what());
+  }
+  vector<language> languages;
+  languages.reserve(views.size());
+  for (auto &v : views) {
+    languages.push_back(to_language(v));
+  }
+  return languages;
+}
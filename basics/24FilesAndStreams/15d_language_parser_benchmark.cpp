@@ -0,0 +1,210 @@
+/*
+-------------------------------------
+ Reading Language Records: Benchmark
+-------------------------------------
+- Makes a big file in the layout of languages2.txt, the records from it
+  over and over with different years, and reads it in five ways
+  * "10assignment": getline, istringstream and >> into the struct. It only
+    reads the first word of a designer, so it gets the multi-word records
+    wrong, but it is timed for comparison
+  * "11assignment": getline, istringstream, a vector of the words and stoi
+  * "11assignment_other": getline, istringstream, words added to the
+    designer until one starts with a digit, and stoi
+  * "mapped views": parse_languages() on the mapped file
+  * "mapped structs": load_languages(), the same but copied into language
+    structs with their own strings
+- The file is read once before timing, so every version reads it from the
+  page cache, and each is then timed reading it a few times
+- The records from the last four are checked against each other
+  (11assignment.cpp puts a space in front of every designer, which is
+  ignored)
+
+build: g++ -std=c++20 -O3 -march=native 15c_language_parser.cpp \
+       15d_language_parser_benchmark.cpp
+run:   ./a.out [records] [file]
+*/
+
+#include "15b_language_parser.h"
+
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// the loops from the three lessons
+
+vector<language> read_10assignment(const string &filename) {
+  vector<language> languages;
+  ifstream ifile(filename);
+  string line;
+  while (getline(ifile, line)) {
+    istringstream is(line);
+    language lang;
+    is >> lang.lang;
+    is >> lang.designer;
+    is >> lang.date;
+    languages.push_back(lang);
+  }
+  return languages;
+}
+
+vector<language> read_11assignment(const string &filename) {
+  vector<language> languages;
+  ifstream ifile(filename);
+  string line;
+  while (getline(ifile, line)) {
+    istringstream is(line);
+    string token;
+    string lang;
+    string designer;
+    int date;
+    vector<string> temp;
+
+    while (is >> token) {
+      temp.push_back(token);
+    }
+
+    lang = temp[0];
+    auto last = end(temp) - 1;
+    date = stoi(*last);
+
+    for (auto it = begin(temp) + 1; it < end(temp) - 1; ++it) {
+      designer += " " + *it;
+    }
+
+    languages.push_back({lang, designer, date});
+  }
+  return languages;
+}
+
+vector<language> read_11assignment_other(const string &filename) {
+  vector<language> languages;
+  ifstream ifile{filename};
+  string line;
+  while (getline(ifile, line)) {
+    string lang;
+    string designer;
+    int year;
+
+    istringstream istring{line};
+    istring >> lang;
+
+    string temp;
+    istring >> temp;
+    designer = temp;
+
+    istring >> temp;
+    while (!isdigit(temp[0])) {
+      designer += " " + temp;
+      istring >> temp;
+    }
+
+    year = stoi(temp);
+    languages.push_back({lang, designer, year});
+  }
+  return languages;
+}
+
+const vector<language> samples{{"C", "Kernighan & Ritchie", 1970},
+                               {"C++", "Stroustrup", 1979},
+                               {"Java", "Gosling", 1991},
+                               {"C#", "Hejlsberg", 1999},
+                               {"Python", "van Rossum", 1991}};
+
+void make_file(const string &filename, int records) {
+  ofstream ofile(filename);
+  for (int i = 0; i < records; ++i) {
+    const language &l = samples[i % samples.size()];
+    ofile << l.lang << " " << l.designer << " " << l.date + i % 30 << "\n";
+  }
+}
+
+// the average seconds for one call of f, over runs calls
+template <typename F> double time_it(int runs, F f) {
+  auto start = steady_clock::now();
+  for (int r = 0; r < runs; ++r) {
+    f();
+  }
+  duration<double> elapsed = steady_clock::now() - start;
+  return elapsed.count() / runs;
+}
+
+bool same_records(const vector<language> &a, const vector<language> &b,
+                  bool b_has_leading_space = false) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); ++i) {
+    string_view designer = b[i].designer;
+    if (b_has_leading_space) {
+      designer.remove_prefix(1);
+    }
+    if (a[i].lang != b[i].lang || a[i].designer != designer ||
+        a[i].date != b[i].date) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  int records = argc > 1 ? stoi(argv[1]) : 2000000;
+  string filename = argc > 2 ? argv[2] : "/tmp/languages_big.txt";
+  const int runs = 3;
+
+  make_file(filename, records);
+  double megabytes;
+  {
+    mapped_file file(filename); // into the page cache
+    megabytes = static_cast<double>(file.size()) / 1e6;
+    cout << records << " records, " << fixed << setprecision(1) << megabytes
+         << " MB\n\n"
+         << defaultfloat;
+  }
+
+  cout << setw(20) << "" << setw(14) << "records/s" << setw(10) << "MB/s"
+       << setw(10) << "speedup" << "\n";
+  double baseline = 0.0;
+  auto row = [&](const char *name, double seconds) {
+    if (baseline == 0.0) {
+      baseline = seconds;
+    }
+    cout << setw(20) << name << fixed << setprecision(0) << setw(14)
+         << records / seconds << setw(10) << megabytes / seconds
+         << setprecision(1) << setw(10) << baseline / seconds << defaultfloat
+         << "\n";
+  };
+
+  vector<language> first, second, third, structs;
+  size_t views = 0;
+  row("10assignment",
+      time_it(runs, [&] { first = read_10assignment(filename); }));
+  row("11assignment",
+      time_it(runs, [&] { second = read_11assignment(filename); }));
+  row("11assignment_other",
+      time_it(runs, [&] { third = read_11assignment_other(filename); }));
+  row("mapped views", time_it(runs, [&] {
+        mapped_file file(filename);
+        views = parse_languages(file.text()).size();
+      }));
+  row("mapped structs",
+      time_it(runs, [&] { structs = load_languages(filename); }));
+
+  bool same = views == structs.size() && same_records(structs, third) &&
+              same_records(structs, second, true) &&
+              first.size() == structs.size();
+  cout << "\nsame records: " << (same ? "yes" : "NO") << "\n";
+
+  // the lessons' own file
+  auto lessons = load_languages("languages2.txt");
+  for (auto &el : lessons) {
+    cout << el.lang << ", " << el.designer << ", " << el.date << "\n";
+  }
+}
@@ -0,0 +1,108 @@
+#ifndef PARALLEL_LINES_H
+#define PARALLEL_LINES_H
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/*
+Parsing a big line-oriented file on several threads
+- A getline loop reads one line at a time, on one thread, however many
+  cores there are. With the whole file in memory (15a_mapped_file.h) the
+  lines can be shared out instead
+- split_lines() cuts the text into one byte range per thread, of about the
+  same size. Each cut is moved on to just after the next '\n', so every
+  line is in exactly one range, whole
+- parse_parallel() gives each range to a thread, which parses it into a
+  vector of its own, so the threads don't share anything while they work
+  * parse(range, out) is any function which appends the records in a range
+    of whole lines to out, for instance parse_languages() from
+    15b_language_parser.h
+  * Then each thread moves its records to their place in the result, which
+    is where they would have been if the file had been read from start to
+    end, so the result is the same as from one thread
+- If parse throws on any thread, the exception from the earliest range is
+  rethrown once all the threads have finished. A line number in it counts
+  from the start of that range, not of the file
+- The records must be default constructible, as the result is sized first
+  and then filled in by the threads
+*/
+
+// one range per part, each starting at the start of a line
+inline std::vector<std::string_view> split_lines(std::string_view text,
+                                                 size_t parts) {
+  std::vector<std::string_view> ranges;
+  parts = std::max<size_t>(parts, 1);
+  size_t begin = 0;
+  for (size_t i = 1; i <= parts && begin < text.size(); ++i) {
+    size_t end = text.size();
+    if (i < parts) {
+      size_t cut = text.size() * i / parts;
+      if (cut <= begin) {
+        continue; // a long line has already taken this part
+      }
+      size_t newline = text.find('\n', cut - 1);
+      end = newline == std::string_view::npos ? text.size() : newline + 1;
+    }
+    ranges.push_back(text.substr(begin, end - begin));
+    begin = end;
+  }
+  return ranges;
+}
+
+// threads == 0 means one for each core
+template <typename T, typename Parse>
+std::vector<T> parse_parallel(std::string_view text, Parse parse,
+                              unsigned threads = 0) {
+  static_assert(std::is_default_constructible_v<T>,
+                "the result is sized before it is filled in");
+  if (threads == 0) {
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  std::vector<std::string_view> ranges = split_lines(text, threads);
+  size_t n = ranges.size();
+  std::vector<std::vector<T>> parts(n);
+  std::vector<std::exception_ptr> errors(n);
+  std::vector<size_t> offsets(n + 1, 0);
+  std::vector<T> result;
+
+  // both phases run on every thread, with the calling thread taking part 0
+  auto run = [n](auto work) {
+    std::vector<std::jthread> workers;
+    for (size_t i = 1; i < n; ++i) {
+      workers.emplace_back(work, i);
+    }
+    if (n > 0) {
+      work(0);
+    }
+  };
+
+  run([&](size_t i) {
+    try {
+      parse(ranges[i], parts[i]);
+    } catch (...) {
+      errors[i] = std::current_exception();
+    }
+  });
+  for (size_t i = 0; i < n; ++i) {
+    if (errors[i]) {
+      std::rethrow_exception(errors[i]);
+    }
+    offsets[i + 1] = offsets[i] + parts[i].size();
+  }
+
+  result.resize(offsets[n]);
+  run([&](size_t i) {
+    std::move(parts[i].begin(), parts[i].end(),
+              result.begin() + static_cast<std::ptrdiff_t>(offsets[i]));
+    std::vector<T>().swap(parts[i]); // free it on the thread that used it
+  });
+  return result;
+}
+
+#endif // PARALLEL_LINES_H
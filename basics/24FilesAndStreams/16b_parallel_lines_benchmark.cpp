@@ -0,0 +1,204 @@
+/*
+--------------------------------------
+ Parallel Parsing of Big Files: Timing
+--------------------------------------
+- Two files, read with parse_parallel() and a range of thread counts
+  * numbers: lines of whitespace separated ints, as in data.txt, read by
+    9StringStreams.cpp with getline and an istringstream per line
+  * languages: records in the layout of languages2.txt, parsed with
+    parse_languages() from 15b_language_parser.h
+- "getline" is the lessons' single threaded loop, for comparison
+- The files are mapped once and read from the page cache, so this is the
+  speed of the parsing, not of the disk. With a file which isn't cached,
+  the threads can go no faster than the disk can deliver the pages
+- Every thread count must give the same records, in the same order
+- More threads than cores can't help, and on a machine with few cores the
+  thread counts above the number of cores show only the overhead
+
+build: g++ -std=c++20 -O3 -march=native 15c_language_parser.cpp \
+       16b_parallel_lines_benchmark.cpp
+run:   ./a.out [megabytes]
+*/
+
+#include "15b_language_parser.h"
+#include "16a_parallel_lines.h"
+
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// the ints in a range of whole lines
+void parse_ints(string_view range, vector<int> &out) {
+  const char *p = range.data();
+  const char *end = p + range.size();
+  while (true) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+      ++p;
+    }
+    if (p == end) {
+      return;
+    }
+    int value;
+    auto [next, ec] = from_chars(p, end, value);
+    if (ec != errc{}) {
+      throw runtime_error("not a number");
+    }
+    out.push_back(value);
+    p = next;
+  }
+}
+
+// 9StringStreams.cpp
+vector<int> read_ints_getline(const string &filename) {
+  ifstream ifile(filename);
+  string line;
+  vector<int> numbers;
+  while (getline(ifile, line)) {
+    istringstream is(line);
+    int num;
+    while (is >> num) {
+      numbers.push_back(num);
+    }
+  }
+  return numbers;
+}
+
+// 11assignment_other.cpp, without the printing
+vector<language> read_languages_getline(const string &filename) {
+  vector<language> languages;
+  ifstream ifile{filename};
+  string line;
+  while (getline(ifile, line)) {
+    istringstream istring{line};
+    string lang, designer, temp;
+    istring >> lang >> designer >> temp;
+    while (!isdigit(temp[0])) {
+      designer += " " + temp;
+      istring >> temp;
+    }
+    languages.push_back({lang, designer, stoi(temp)});
+  }
+  return languages;
+}
+
+void make_numbers(const string &filename, size_t bytes) {
+  ofstream ofile(filename);
+  mt19937 rng(1);
+  uniform_int_distribution<int> value(-1000000, 1000000);
+  uniform_int_distribution<int> per_line(1, 12);
+  size_t written = 0;
+  string line;
+  while (written < bytes) {
+    line.clear();
+    for (int i = per_line(rng); i > 0; --i) {
+      line += to_string(value(rng));
+      line += ' ';
+    }
+    line += '\n';
+    ofile << line;
+    written += line.size();
+  }
+}
+
+void make_languages(const string &filename, size_t bytes) {
+  const char *lines[] = {"C Kernighan & Ritchie ", "C++ Stroustrup ",
+                         "Java Gosling ", "C# Hejlsberg ",
+                         "Python van Rossum "};
+  ofstream ofile(filename);
+  size_t written = 0;
+  for (int i = 0; written < bytes; ++i) {
+    string line = lines[i % 5] + to_string(1950 + i % 70) + "\n";
+    ofile << line;
+    written += line.size();
+  }
+}
+
+template <typename F> double time_it(int runs, F f) {
+  auto start = steady_clock::now();
+  for (int r = 0; r < runs; ++r) {
+    f();
+  }
+  duration<double> elapsed = steady_clock::now() - start;
+  return elapsed.count() / runs;
+}
+
+vector<unsigned> thread_counts() {
+  unsigned cores = max(thread::hardware_concurrency(), 1u);
+  vector<unsigned> counts;
+  for (unsigned t = 1; t <= cores; t *= 2) {
+    counts.push_back(t);
+  }
+  if (counts.back() != cores) {
+    counts.push_back(cores);
+  }
+  counts.push_back(cores * 2);
+  return counts;
+}
+
+// times getline, then parse_parallel with each thread count
+template <typename T, typename Getline, typename Parse, typename Same>
+void benchmark(const string &name, const string &filename, Getline getline,
+               Parse parse, Same same) {
+  const int runs = 3;
+  mapped_file file(filename);
+  double megabytes = static_cast<double>(file.size()) / 1e6;
+  cout << name << ", " << fixed << setprecision(1) << megabytes << " MB\n"
+       << defaultfloat;
+  cout << setw(12) << "threads" << setw(10) << "MB/s" << setw(10)
+       << "speedup" << setw(8) << "same" << "\n";
+
+  auto expected = getline(filename);
+  double slow = time_it(runs, [&] { expected = getline(filename); });
+  cout << setw(12) << "getline" << fixed << setprecision(0) << setw(10)
+       << megabytes / slow << setprecision(1) << setw(10) << 1.0
+       << defaultfloat << setw(8) << "" << "\n";
+
+  for (unsigned threads : thread_counts()) {
+    vector<T> records;
+    double seconds = time_it(runs, [&] {
+      records = parse_parallel<T>(file.text(), parse, threads);
+    });
+    cout << setw(12) << threads << fixed << setprecision(0) << setw(10)
+         << megabytes / seconds << setprecision(1) << setw(10)
+         << slow / seconds << defaultfloat << setw(8)
+         << (same(expected, records) ? "yes" : "NO") << "\n";
+  }
+  cout << "\n";
+}
+
+int main(int argc, char *argv[]) {
+  size_t megabytes = argc > 1 ? stoul(argv[1]) : 100;
+  string numbers = "/tmp/numbers_big.txt";
+  string languages = "/tmp/languages_big.txt";
+  make_numbers(numbers, megabytes * 1000000);
+  make_languages(languages, megabytes * 1000000);
+  cout << thread::hardware_concurrency() << " hardware threads\n\n";
+
+  benchmark<int>(numbers, numbers, read_ints_getline, parse_ints,
+                 [](const vector<int> &a, const vector<int> &b) {
+                   return a == b;
+                 });
+
+  benchmark<language_view>(
+      languages, languages, read_languages_getline,
+      [](string_view range, vector<language_view> &out) {
+        out = parse_languages(range);
+      },
+      [](const vector<language> &a, const vector<language_view> &b) {
+        return equal(a.begin(), a.end(), b.begin(), b.end(),
+                     [](const language &x, const language_view &y) {
+                       return x.lang == y.lang && x.designer == y.designer &&
+                              x.date == y.date;
+                     });
+      });
+}
@@ -0,0 +1,42 @@
+#ifndef INT_TOKENIZER_H
+#define INT_TOKENIZER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+Reading a big file of ints, 64 bytes at a time
+- 9StringStreams.cpp reads data.txt with an istringstream per line and >>,
+  which for every number goes through the stream's sentry, the locale's
+  num_get facet and its error handling. 13StreamIterators.cpp's
+  istream_iterator<int> does the same, one >> per number
+- read_ints() looks at the text 64 bytes at a time instead
+  * SIMD compares turn the 64 bytes into bit masks: which are digits,
+    which are '-' and which are whitespace. With AVX2 that is two loads,
+    with SSE2 four, and there is a plain loop for other machines
+  * A number starts where a digit or '-' follows something else, so all
+    the starts in the 64 bytes come from one shift and mask, and each
+    number's length is a count of trailing zeros
+  * Up to 8 digits are converted in one go: they are loaded as a uint64_t
+    and combined in pairs, fours and eights with three multiplies (the
+    "SWAR" trick). 9 and 10 digit numbers take one more step
+  * A number which runs past the 64 bytes is picked up again at the start
+    of the next 64
+  * The last few bytes are copied into a buffer padded with spaces, so the
+    loads near the end of the text never go past it
+- Anything which isn't whitespace or an int which fits in an int, such as
+  "12x", "--3" or 3000000000, throws std::runtime_error with its position.
+  A number with more than 63 characters, even leading zeros, is rejected
+- The numbers are appended to numbers, as the fill loop in 9StringStreams.cpp
+  does
+    vector<int> numbers = read_ints("data.txt");
+*/
+
+// appends the ints in text to numbers
+void parse_ints(std::string_view text, std::vector<int> &numbers);
+
+// the ints in a whitespace separated file
+std::vector<int> read_ints(const std::string &filename);
+
+#endif // INT_TOKENIZER_H
@@ -0,0 +1,248 @@
+#include "17a_int_tokenizer.h"
+#include "15a_mapped_file.h"
+
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+static_assert(endian::native == endian::little,
+              "the digits are loaded as little-endian words");
+
+constexpr size_t window = 64; // bytes looked at in one go
+constexpr size_t slack = 8;   // a digit load can read this far past it
+
+struct masks {
+  uint64_t digit;
+  uint64_t minus;
+  uint64_t space; // ' ', '\t', '\n', '\v', '\f' and '\r'
+};
+
+#if defined(__AVX2__)
+masks classify(const char *p) {
+  const __m256i zero = _mm256_set1_epi8('0');
+  const __m256i nine = _mm256_set1_epi8(9);
+  const __m256i tab = _mm256_set1_epi8('\t');
+  const __m256i four = _mm256_set1_epi8(4); // '\t' to '\r'
+  const __m256i blank = _mm256_set1_epi8(' ');
+  const __m256i dash = _mm256_set1_epi8('-');
+  masks m{0, 0, 0};
+  for (int half = 0; half < 2; ++half) {
+    __m256i v = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(p + 32 * half));
+    // c - first <= count, unsigned, is c in [first, first + count]
+    __m256i d = _mm256_sub_epi8(v, zero);
+    __m256i digit = _mm256_cmpeq_epi8(_mm256_min_epu8(d, nine), d);
+    __m256i c = _mm256_sub_epi8(v, tab);
+    __m256i space =
+        _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(c, four), c),
+                        _mm256_cmpeq_epi8(v, blank));
+    __m256i minus = _mm256_cmpeq_epi8(v, dash);
+    int shift = 32 * half;
+    m.digit |= uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(digit))}
+               << shift;
+    m.space |= uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(space))}
+               << shift;
+    m.minus |= uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(minus))}
+               << shift;
+  }
+  return m;
+}
+#elif defined(__SSE2__)
+masks classify(const char *p) {
+  const __m128i zero = _mm_set1_epi8('0');
+  const __m128i nine = _mm_set1_epi8(9);
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i four = _mm_set1_epi8(4);
+  const __m128i blank = _mm_set1_epi8(' ');
+  const __m128i dash = _mm_set1_epi8('-');
+  masks m{0, 0, 0};
+  for (int quarter = 0; quarter < 4; ++quarter) {
+    __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16 * quarter));
+    __m128i d = _mm_sub_epi8(v, zero);
+    __m128i digit = _mm_cmpeq_epi8(_mm_min_epu8(d, nine), d);
+    __m128i c = _mm_sub_epi8(v, tab);
+    __m128i space = _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(c, four), c),
+                                 _mm_cmpeq_epi8(v, blank));
+    __m128i minus = _mm_cmpeq_epi8(v, dash);
+    int shift = 16 * quarter;
+    m.digit |= uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(digit))}
+               << shift;
+    m.space |= uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(space))}
+               << shift;
+    m.minus |= uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(minus))}
+               << shift;
+  }
+  return m;
+}
+#else
+masks classify(const char *p) {
+  masks m{0, 0, 0};
+  for (size_t i = 0; i < window; ++i) {
+    auto c = static_cast<unsigned char>(p[i]);
+    uint64_t bit = uint64_t{1} << i;
+    if (c >= '0' && c <= '9') {
+      m.digit |= bit;
+    } else if (c == ' ' || (c >= '\t' && c <= '\r')) {
+      m.space |= bit;
+    } else if (c == '-') {
+      m.minus |= bit;
+    }
+  }
+  return m;
+}
+#endif
+
+// the value of 8 digits, which are the 8 bytes of x, the first digit lowest
+uint64_t combine_eight(uint64_t x) {
+  x = (x & 0x0f0f0f0f0f0f0f0f) * 2561 >> 8;              // pairs
+  x = (x & 0x00ff00ff00ff00ff) * 6553601 >> 16;          // fours
+  return (x & 0x0000ffff0000ffff) * 42949672960001 >> 32; // eights
+}
+
+// the value of the digits p[0] to p[count - 1], for count from 1 to 8
+// reads 8 bytes from p
+uint64_t few_digits(const char *p, size_t count) {
+  uint64_t x;
+  memcpy(&x, p, sizeof x);
+  // the digits go to the top of the word, the bytes after them fall off
+  // and zeros come in at the bottom, which are leading zeros
+  return combine_eight(x << (8 * (8 - count)));
+}
+
+[[noreturn]] void not_an_int(size_t position) {
+  throw runtime_error("byte " + to_string(position) + ": not an int");
+}
+
+// converts every number starting before stop, looking at window bytes from
+// pos at a time. base must be readable up to stop + window + slack
+// The numbers go into numbers from index used on, which is moved on past
+// them. numbers is grown as needed, so it can be longer than used
+// returns where to carry on from: at or after stop, and never in the
+// middle of a number
+// offset is added to positions in error messages
+size_t parse_windows(const char *base, size_t pos, size_t stop,
+                     vector<int> &numbers, size_t &used, size_t offset) {
+  while (pos < stop) {
+    if (numbers.size() - used < window) {
+      numbers.resize(max(numbers.size() * 2, used + window));
+    }
+    int *out = numbers.data() + used;
+
+    masks m = classify(base + pos);
+    uint64_t token = m.digit | m.minus;
+    // pos is never in the middle of a number, so bit 0 can be a start
+    uint64_t starts = token & ~(token << 1);
+
+    // everything in the window is checked at once: a byte which can't be
+    // in a number or between them, a '-' which isn't at the start of a
+    // number, or one which isn't followed by a digit (which for the last
+    // byte is in the next window)
+    uint64_t bad = ~(token | m.space) | (m.minus & ~starts) |
+                   (m.minus & ~(m.digit >> 1) & (~uint64_t{0} >> 1));
+    if (bad) {
+      not_an_int(offset + pos + countr_zero(bad));
+    }
+
+    uint64_t before_stop = stop - pos >= window
+                               ? ~uint64_t{0}
+                               : (uint64_t{1} << (stop - pos)) - 1;
+    uint64_t next = pos + window;
+    for (uint64_t s = starts & before_stop; s; s &= s - 1) {
+      size_t first = countr_zero(s);
+      uint64_t after = ~token >> first;
+      if (after == 0) {
+        // it runs past the window: start the next one here
+        if (first == 0) {
+          not_an_int(offset + pos); // longer than a whole window
+        }
+        next = pos + first;
+        break;
+      }
+      size_t end = first + countr_zero(after);
+      bool negative = m.minus >> first & 1;
+      size_t digits = first + negative;
+      size_t count = end - digits;
+      if (count > 10) {
+        while (count > 10 && base[pos + digits] == '0') {
+          ++digits;
+          --count;
+        }
+        if (count > 10) {
+          not_an_int(offset + pos + first);
+        }
+      }
+
+      const char *p = base + pos + digits;
+      uint64_t value;
+      if (count <= 8) {
+        value = few_digits(p, count);
+      } else {
+        value = few_digits(p, count - 8) * 100000000 +
+                few_digits(p + count - 8, 8);
+      }
+      if (value > (negative ? uint64_t{INT_MAX} + 1 : uint64_t{INT_MAX})) {
+        not_an_int(offset + pos + first);
+      }
+      auto signed_value = static_cast<int64_t>(value);
+      *out++ = static_cast<int>(negative ? -signed_value : signed_value);
+    }
+    used = static_cast<size_t>(out - numbers.data());
+
+    if (next == pos + window) {
+      // a number which starts after stop, for the caller
+      uint64_t later = starts & ~before_stop;
+      if (later) {
+        next = pos + countr_zero(later);
+      }
+    }
+    pos = next;
+  }
+  return pos;
+}
+
+} // namespace
+
+void parse_ints(string_view text, vector<int> &numbers) {
+  size_t used = numbers.size();
+  try {
+    size_t pos = 0;
+    if (text.size() >= window + slack) {
+      pos = parse_windows(text.data(), 0, text.size() - window - slack,
+                          numbers, used, 0);
+    }
+    // what's left is at most window + slack bytes, which go into a buffer
+    // with enough spaces after them for the loads
+    char tail[2 * (window + slack)];
+    memset(tail, ' ', sizeof tail);
+    size_t rest = text.size() - pos;
+    memcpy(tail, text.data() + pos, rest);
+    parse_windows(tail, 0, rest, numbers, used, pos);
+  } catch (...) {
+    numbers.resize(used); // the numbers before the error
+    throw;
+  }
+  numbers.resize(used);
+}
+
+vector<int> read_ints(const string &filename) {
+  mapped_file file(filename);
+  vector<int> numbers;
+  try {
+    parse_ints(file.text(), numbers);
+  } catch (const runtime_error &e) {
+    throw runtime_error(filename + ": " + e.what());
+  }
+  return numbers;
+}
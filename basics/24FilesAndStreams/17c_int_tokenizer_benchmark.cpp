@@ -0,0 +1,158 @@
+/*
+--------------------------------
+ Reading Ints: Benchmark
+--------------------------------
+- A big file in the layout of data.txt: lines of whitespace separated ints,
+  some negative, of all sizes
+- Read into a vector<int> in five ways
+  * "istringstream": getline and an istringstream per line, as in
+    9StringStreams.cpp
+  * "istream_iterator": istream_iterator<int> on an ifstream, as in
+    13StreamIterators.cpp
+  * "from_chars": the mapped file, whitespace skipped a byte at a time and
+    each number converted with std::from_chars
+  * "read_ints": 17a_int_tokenizer.h
+  * "parallel read_ints": parse_ints() on each range from
+    16a_parallel_lines.h, with a thread for each core
+- The file is read once first, so each version reads it from the page cache
+- All five must read the same numbers
+
+build: g++ -std=c++20 -O3 -march=native 17b_int_tokenizer.cpp \
+       17c_int_tokenizer_benchmark.cpp
+run:   ./a.out [megabytes]
+*/
+
+#include "15a_mapped_file.h"
+#include "16a_parallel_lines.h"
+#include "17a_int_tokenizer.h"
+
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+vector<int> read_istringstream(const string &filename) {
+  ifstream ifile(filename);
+  string line;
+  vector<int> numbers;
+  while (getline(ifile, line)) {
+    istringstream is(line);
+    int num;
+    while (is >> num) {
+      numbers.push_back(num);
+    }
+  }
+  return numbers;
+}
+
+vector<int> read_istream_iterator(const string &filename) {
+  ifstream ifile(filename);
+  return vector<int>(istream_iterator<int>(ifile), istream_iterator<int>());
+}
+
+vector<int> read_from_chars(const string &filename) {
+  mapped_file file(filename);
+  vector<int> numbers;
+  const char *p = file.text().data();
+  const char *end = p + file.size();
+  while (true) {
+    while (p < end && (*p == ' ' || (*p >= '\t' && *p <= '\r'))) {
+      ++p;
+    }
+    if (p == end) {
+      return numbers;
+    }
+    int value;
+    auto [next, ec] = from_chars(p, end, value);
+    if (ec != errc{}) {
+      throw runtime_error(filename + ": not an int");
+    }
+    numbers.push_back(value);
+    p = next;
+  }
+}
+
+vector<int> read_ints_parallel(const string &filename) {
+  mapped_file file(filename);
+  return parse_parallel<int>(file.text(), parse_ints);
+}
+
+// numbers of every length, more short ones than long ones, as in real data
+void make_file(const string &filename, size_t bytes) {
+  ofstream ofile(filename);
+  mt19937 rng(1);
+  uniform_int_distribution<int> digits(1, 10);
+  uniform_int_distribution<int> per_line(1, 16);
+  bernoulli_distribution negative(0.25);
+  string line;
+  size_t written = 0;
+  while (written < bytes) {
+    line.clear();
+    for (int i = per_line(rng); i > 0; --i) {
+      int d = min(digits(rng), digits(rng));
+      long long limit = 1;
+      for (int k = 0; k < d; ++k) {
+        limit *= 10;
+      }
+      long long value = uniform_int_distribution<long long>(
+          0, min(limit - 1, 2147483647ll))(rng);
+      line += to_string(negative(rng) ? -value : value);
+      line += i > 1 ? " " : "\n";
+    }
+    ofile << line;
+    written += line.size();
+  }
+}
+
+template <typename F> double time_it(int runs, F f) {
+  auto start = steady_clock::now();
+  for (int r = 0; r < runs; ++r) {
+    f();
+  }
+  duration<double> elapsed = steady_clock::now() - start;
+  return elapsed.count() / runs;
+}
+
+int main(int argc, char *argv[]) {
+  size_t megabytes = argc > 1 ? stoul(argv[1]) : 100;
+  string filename = "/tmp/ints_big.txt";
+  make_file(filename, megabytes * 1000000);
+  const int runs = 3;
+
+  vector<int> expected = read_from_chars(filename);
+  double size = static_cast<double>(mapped_file(filename).size()) / 1e6;
+  cout << expected.size() << " ints, " << fixed << setprecision(1) << size
+       << " MB\n\n"
+       << defaultfloat;
+
+  cout << setw(22) << "" << setw(10) << "MB/s" << setw(14) << "M ints/s"
+       << setw(10) << "speedup" << setw(8) << "same" << "\n";
+  double baseline = 0.0;
+  auto row = [&](const char *name, vector<int> (*read)(const string &)) {
+    vector<int> numbers;
+    double seconds = time_it(runs, [&] { numbers = read(filename); });
+    if (baseline == 0.0) {
+      baseline = seconds;
+    }
+    cout << setw(22) << name << fixed << setprecision(0) << setw(10)
+         << size / seconds << setprecision(1) << setw(14)
+         << expected.size() / seconds / 1e6 << setw(10) << baseline / seconds
+         << defaultfloat << setw(8) << (numbers == expected ? "yes" : "NO")
+         << "\n";
+  };
+  row("istringstream", read_istringstream);
+  row("istream_iterator", read_istream_iterator);
+  row("from_chars", read_from_chars);
+  row("read_ints", read_ints);
+  row("parallel read_ints", read_ints_parallel);
+}
@@ -0,0 +1,197 @@
+/*
+--------------------------------
+Reading Ints: Checks
+--------------------------------
+- 17c_int_tokenizer_benchmark.cpp only reads good files. These are the
+  checks for everything parse_ints() must refuse, on whichever classify()
+  it was built with: AVX2, SSE2 or the plain loop
+- A table of bad tokens, each with the byte it must be reported at. Every
+  one is tried after 0 to 80 spaces, so it sits across the 16, 32 and 64
+  byte blocks the classify()s work in, and both with and without enough
+  text after it to be parsed from the file itself rather than the padded
+  buffer at the end
+- Tokens as long as a number can be, 63 characters, and one longer
+- Random text, good and bad, against std::from_chars on each token
+- Build it three times, once for each classify()
+
+build: g++ -std=c++20 -O2 -mavx2 17b_int_tokenizer.cpp \
+       17d_int_tokenizer_check.cpp
+       g++ -std=c++20 -O2 17b_int_tokenizer.cpp 17d_int_tokenizer_check.cpp
+       g++ -std=c++20 -O2 -mno-avx2 -mno-avx -mno-sse2 \
+       17b_int_tokenizer.cpp 17d_int_tokenizer_check.cpp
+*/
+
+#include "17a_int_tokenizer.h"
+
+#include <charconv>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// the byte parse_ints() reports, or nothing if it doesn't throw
+optional<size_t> error_at(const string &text) {
+  vector<int> numbers;
+  try {
+    parse_ints(text, numbers);
+  } catch (const runtime_error &e) {
+    string message = e.what();
+    size_t at = message.find("byte ");
+    return at == string::npos ? SIZE_MAX : stoul(message.substr(at + 5));
+  }
+  return nullopt;
+}
+
+bool is_space(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+// each whitespace separated token through from_chars, false if one isn't
+// an int
+bool reference(const string &text, vector<int> &numbers) {
+  size_t i = 0;
+  while (true) {
+    while (i < text.size() && is_space(text[i])) {
+      ++i;
+    }
+    if (i == text.size()) {
+      return true;
+    }
+    size_t end = i;
+    while (end < text.size() && !is_space(text[end])) {
+      ++end;
+    }
+    int value;
+    auto [p, ec] = from_chars(text.data() + i, text.data() + end, value);
+    if (ec != errc{} || p != text.data() + end) {
+      return false;
+    }
+    numbers.push_back(value);
+    i = end;
+  }
+}
+
+struct bad_token {
+  string text;
+  size_t at; // the byte which must be reported
+};
+
+const bad_token bad_tokens[]{
+    {"12x", 2},          {"--3", 0},         {"-", 0},
+    {"3-", 1},           {"1-2", 1},         {"+5", 0},
+    {"1.5", 1},          {"x", 0},           {"\x80", 0},
+    {"3000000000", 0},   {"2147483648", 0},  {"-2147483649", 0},
+    {"99999999999", 0},  {"12 4x", 4},       {"7 -", 2},
+};
+
+// good text after the token, so that it is parsed a window at a time from
+// the text itself and not from the padded buffer at the end
+const string after = [] {
+  string s;
+  for (int i = 0; i < 40; ++i) {
+    s += " " + to_string(i * 7919);
+  }
+  return s;
+}();
+
+int main() {
+#if defined(__AVX2__)
+  cout << "classify: AVX2\n";
+#elif defined(__SSE2__)
+  cout << "classify: SSE2\n";
+#else
+  cout << "classify: plain loop\n";
+#endif
+  bool ok = true;
+  auto check = [&ok](const string &what, bool passed) {
+    cout << setw(44) << left << what << (passed ? "yes" : "NO") << right
+         << "\n";
+    ok = ok && passed;
+  };
+
+  bool reported = true;
+  for (const bad_token &bad : bad_tokens) {
+    for (size_t spaces = 0; spaces <= 80; ++spaces) {
+      string text = string(spaces, ' ') + bad.text;
+      for (const string &tail : {string(), " " + after}) {
+        optional<size_t> at = error_at(text + tail);
+        if (at != spaces + bad.at) {
+          reported = false;
+          cout << "  \"" << bad.text << "\" after " << spaces
+               << " spaces: " << (at ? to_string(*at) : "not refused")
+               << "\n";
+        }
+      }
+    }
+  }
+  check("bad tokens refused at the right byte", reported);
+
+  // 63 characters is the longest a number can be, leading zeros and all
+  bool longest = true;
+  for (size_t spaces = 0; spaces <= 80; ++spaces) {
+    for (const string &tail : {string(), " " + after}) {
+      string pad(spaces, ' ');
+      vector<int> numbers;
+      parse_ints(pad + string(62, '0') + "7" + tail, numbers);
+      longest = longest && numbers.size() > 0 && numbers[0] == 7;
+      numbers.clear();
+      parse_ints(pad + "-" + string(61, '0') + "5" + tail, numbers);
+      longest = longest && numbers.size() > 0 && numbers[0] == -5;
+      longest = longest &&
+                error_at(pad + string(63, '0') + "7" + tail) == spaces;
+    }
+  }
+  check("63 character numbers read, 64 refused", longest);
+
+  // mostly numbers, some of them too big or with junk on the end, or runs
+  // of just the characters numbers are made of
+  mt19937 rng(7);
+  const char *pieces[]{" ", "\n", "\t", "\r\n", "-", "0", "1", "5", "9", "  "};
+  int mismatches = 0;
+  int refused = 0;
+  const int tries = 100000;
+  for (int t = 0; t < tries; ++t) {
+    string text;
+    size_t length = rng() % 300;
+    bool junk = rng() % 4 == 0;
+    while (text.size() < length) {
+      if (junk) {
+        text += pieces[rng() % 10];
+        continue;
+      }
+      long long value = static_cast<long long>(rng() % 4294967296ull) -
+                        2147483648ll;
+      if (rng() % 5 == 0) {
+        value = rng() % 100000;
+      }
+      if (rng() % 50 == 0) {
+        value = value * 10 + 7; // often too big
+      }
+      string number = to_string(value);
+      if (rng() % 40 == 0) {
+        number = string(rng() % 15, '0') + number;
+      }
+      if (rng() % 200 == 0) {
+        number += "x";
+      }
+      text += number + pieces[rng() % 4] + string(rng() % 3 ? 0 : 70, ' ');
+    }
+    vector<int> expected, numbers;
+    bool expected_ok = reference(text, expected);
+    bool parsed = !error_at(text);
+    if (parsed) {
+      parse_ints(text, numbers);
+    } else {
+      ++refused;
+    }
+    if (parsed != expected_ok || (parsed && numbers != expected)) {
+      ++mismatches;
+    }
+  }
+  cout << tries << " random texts, " << refused << " of them bad\n";
+  check("random text matches from_chars", mismatches == 0);
+  return ok ? 0 : 1;
+}
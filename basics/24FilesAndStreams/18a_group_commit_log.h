@@ -0,0 +1,136 @@
+#ifndef GROUP_COMMIT_LOG_H
+#define GROUP_COMMIT_LOG_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/*
+A log file which is fast and doesn't lose much
+- 3StreamsAndBuffering.cpp shows the two ways of writing a log with an
+  ofstream
+  * Let the stream buffer it: fast, but whatever is still in the buffer is
+    lost when the program dies, and even what has been written can be lost
+    with the machine, as it is only in the OS's page cache
+  * flush after every line: the OS has every line, but there is a system
+    call per line, and it is still not on the disk
+- group_commit_log writes lines from any number of threads to a file
+  * append() copies the line into a ring buffer in memory and returns. It
+    doesn't take a lock or make a system call
+  * A background thread, the flusher, takes everything that is in the ring
+    and writes it with one write() followed by one fdatasync(). That puts a
+    whole group of lines on the disk for the price of one
+  * The flusher is woken when batch_bytes are waiting, or every interval,
+    whichever comes first
+  * sync() waits until everything appended so far is on the disk, for the
+    lines which must not be lost
+- How much can be lost
+  * The flusher only hands a line's space in the ring back once the line
+    has been written, and append() waits for space rather than go past
+    buffer_bytes. So if the program dies, at most buffer_bytes of lines
+    are lost, and if the machine dies, at most twice that, as the lines
+    written since the last fdatasync() can go too
+  * Usually it is much less: min(batch_bytes, interval * the rate lines
+    are appended at), plus whatever comes in before the flusher gets the
+    CPU. On a machine with one core that wait is the bigger part
+  * The defaults, a 64 KiB ring woken every 8 KiB, the size of an
+    ofstream's buffer, lose about as much as the buffered ofstream does.
+    A bigger ring makes append() wait less and is faster, at the price of
+    losing more
+- The ring buffer
+  * Every line appended is given a position in the log, its "log sequence
+    number". A thread claims the space for its line by adding the line's
+    size to head with one atomic fetch_add, so threads never wait for each
+    other, only for space when the ring is full
+  * Each record in the ring is an 8 byte header and then the line. The
+    thread copies the line in and then stores its length in the header,
+    which is what tells the flusher the record is complete
+  * The flusher reads complete records in order from tail, zeroes the space
+    they took and moves tail on, which frees the space for new lines. It
+    stops at a record whose header is still 0
+  * append() returns the log position just after the line, and
+    wait_durable(position) waits until the file is synced that far
+- If a write() or fdatasync() fails the error is kept, and thrown as a
+  std::system_error from the next append(), sync() or wait_durable()
+- The destructor writes and syncs everything before it returns
+*/
+
+class group_commit_log {
+public:
+  struct options {
+    size_t buffer_bytes{size_t{64} << 10};  // the ring, rounded up to 2^n
+    size_t batch_bytes{size_t{8} << 10};    // wake the flusher at this much
+    std::chrono::milliseconds interval{10}; // or after this long
+  };
+
+  struct statistics {
+    uint64_t bytes;  // written to the file
+    uint64_t writes; // write() calls
+    uint64_t syncs;  // fdatasync() calls
+    uint64_t waits;  // times append() found the ring full
+  };
+
+  explicit group_commit_log(const std::string &filename)
+      : group_commit_log(filename, options{}) {}
+  group_commit_log(const std::string &filename, options opts);
+  ~group_commit_log();
+
+  group_commit_log(const group_commit_log &) = delete;
+  group_commit_log &operator=(const group_commit_log &) = delete;
+
+  // appends text as it is, with no '\n' added
+  // text must fit in the ring, less its header
+  uint64_t append(std::string_view text);
+
+  void wait_durable(uint64_t position);
+  void sync() { wait_durable(head.load(std::memory_order_acquire)); }
+
+  statistics stats() const;
+
+private:
+  static constexpr size_t header_bytes = 8;
+
+  int fd{-1};
+  options opts;
+  std::unique_ptr<uint64_t[]> ring; // uint64_t so the headers are aligned
+  size_t capacity;                  // in bytes
+  size_t mask;
+
+  // producers
+  alignas(64) std::atomic<uint64_t> head{0}; // space claimed up to here
+  std::atomic<uint64_t> waits{0};
+
+  // the flusher
+  alignas(64) std::atomic<uint64_t> tail{0}; // space freed up to here
+  std::atomic<uint64_t> durable{0};          // synced up to here
+  std::atomic<uint64_t> wanted{0}; // a sync() is waiting for this position
+  std::atomic<int> error{0};       // errno of a failed call
+  std::atomic<uint64_t> written{0};
+  std::atomic<uint64_t> writes{0};
+  std::atomic<uint64_t> syncs{0};
+  std::vector<char> staging; // what the flusher writes
+
+  std::mutex wake_mutex;
+  std::condition_variable wake;       // for the flusher
+  std::condition_variable durable_cv; // for wait_durable()
+  bool stopping{false};               // guarded by wake_mutex
+  std::thread flusher;
+
+  char *bytes() { return reinterpret_cast<char *>(ring.get()); }
+  void copy_in(uint64_t position, const char *text, size_t size);
+  void copy_out(uint64_t position, char *out, size_t size);
+  void check_error() const;
+  void wake_flusher();
+  bool drain(); // false if there was nothing to write
+  void run();
+};
+
+#endif // GROUP_COMMIT_LOG_H
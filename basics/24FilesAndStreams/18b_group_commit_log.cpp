@@ -0,0 +1,211 @@
+#include "18a_group_commit_log.h"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <system_error>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+constexpr size_t round_up(size_t size) { return (size + 7) & ~size_t{7}; }
+
+} // namespace
+
+group_commit_log::group_commit_log(const string &filename, options opts)
+    : opts(opts) {
+  fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+              0644);
+  if (fd < 0) {
+    throw system_error(errno, generic_category(), filename);
+  }
+  capacity = bit_ceil(max<size_t>(opts.buffer_bytes, 4096));
+  mask = capacity - 1;
+  this->opts.batch_bytes = clamp<size_t>(opts.batch_bytes, 1, capacity);
+  ring = make_unique<uint64_t[]>(capacity / sizeof(uint64_t)); // zeroed
+  staging.reserve(capacity);
+  flusher = thread(&group_commit_log::run, this);
+}
+
+group_commit_log::~group_commit_log() {
+  {
+    lock_guard<mutex> lock(wake_mutex);
+    stopping = true;
+  }
+  wake.notify_one();
+  flusher.join();
+  ::close(fd);
+}
+
+void group_commit_log::copy_in(uint64_t position, const char *text,
+                               size_t size) {
+  size_t offset = position & mask;
+  size_t first = min(size, capacity - offset);
+  memcpy(bytes() + offset, text, first);
+  memcpy(bytes(), text + first, size - first); // wrapped round
+}
+
+void group_commit_log::copy_out(uint64_t position, char *out, size_t size) {
+  size_t offset = position & mask;
+  size_t first = min(size, capacity - offset);
+  memcpy(out, bytes() + offset, first);
+  memcpy(out + first, bytes(), size - first);
+}
+
+void group_commit_log::check_error() const {
+  if (int e = error.load(memory_order_acquire)) {
+    throw system_error(e, generic_category(), "group_commit_log");
+  }
+}
+
+// no lock: if the flusher misses this, it wakes up after interval anyway
+void group_commit_log::wake_flusher() { wake.notify_one(); }
+
+uint64_t group_commit_log::append(string_view text) {
+  check_error();
+  size_t record = round_up(header_bytes + text.size());
+  if (record > capacity) {
+    throw length_error("group_commit_log: line longer than the buffer");
+  }
+
+  uint64_t position = head.fetch_add(record, memory_order_relaxed);
+  uint64_t end = position + record;
+  uint64_t freed = tail.load(memory_order_acquire);
+  if (end - freed > capacity) {
+    waits.fetch_add(1, memory_order_relaxed);
+    wake_flusher();
+    while (end - freed > capacity) {
+      tail.wait(freed, memory_order_acquire);
+      freed = tail.load(memory_order_acquire);
+    }
+  }
+
+  copy_in(position + header_bytes, text.data(), text.size());
+  // the length, plus one so that an empty line isn't 0, is what marks the
+  // record as complete
+  atomic_ref<uint64_t>(ring[(position & mask) / sizeof(uint64_t)])
+      .store(text.size() + 1, memory_order_release);
+
+  if (position / opts.batch_bytes != end / opts.batch_bytes) {
+    wake_flusher();
+  }
+  return end;
+}
+
+void group_commit_log::wait_durable(uint64_t position) {
+  check_error();
+  if (durable.load(memory_order_acquire) >= position) {
+    return;
+  }
+  uint64_t w = wanted.load(memory_order_relaxed);
+  while (w < position && !wanted.compare_exchange_weak(w, position)) {
+  }
+  wake_flusher();
+  unique_lock<mutex> lock(wake_mutex);
+  durable_cv.wait(lock, [&] {
+    return durable.load(memory_order_acquire) >= position ||
+           error.load(memory_order_acquire) != 0;
+  });
+  check_error();
+}
+
+group_commit_log::statistics group_commit_log::stats() const {
+  return {written.load(), writes.load(), syncs.load(), waits.load()};
+}
+
+bool group_commit_log::drain() {
+  uint64_t start = tail.load(memory_order_relaxed); // only moved here
+  uint64_t position = start;
+  staging.clear();
+  while (position - start < capacity) {
+    uint64_t header =
+        atomic_ref<uint64_t>(ring[(position & mask) / sizeof(uint64_t)])
+            .load(memory_order_acquire);
+    if (header == 0) {
+      break; // not written yet, or nothing more claimed
+    }
+    size_t size = header - 1;
+    size_t old = staging.size();
+    staging.resize(old + size);
+    copy_out(position + header_bytes, staging.data() + old, size);
+    position += round_up(header_bytes + size);
+  }
+  if (position == start) {
+    return false;
+  }
+
+  // the lines are written before their space is handed back, so that no
+  // more than the ring's worth of them can be lost with the program
+  bool failed = error.load(memory_order_relaxed) != 0;
+  const char *p = staging.data();
+  size_t left = staging.size();
+  while (left > 0 && !failed) {
+    ssize_t n = ::write(fd, p, left);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      error.store(errno, memory_order_release);
+      failed = true;
+    } else {
+      p += n;
+      left -= static_cast<size_t>(n);
+    }
+  }
+
+  // zero what the records took, so a header which is put there later
+  // reads 0 until it is written, then hand the space back. After an error
+  // the lines are lost, but the producers mustn't block
+  size_t offset = start & mask;
+  size_t size = position - start;
+  size_t first = min(size, capacity - offset);
+  memset(bytes() + offset, 0, first);
+  memset(bytes(), 0, size - first);
+  tail.store(position, memory_order_release);
+  tail.notify_all();
+  if (failed) {
+    return true;
+  }
+
+  writes.fetch_add(1, memory_order_relaxed);
+  written.fetch_add(staging.size(), memory_order_relaxed);
+  if (fdatasync(fd) != 0) {
+    error.store(errno, memory_order_release);
+    return true;
+  }
+  syncs.fetch_add(1, memory_order_relaxed);
+  durable.store(position, memory_order_release);
+  return true;
+}
+
+void group_commit_log::run() {
+  unique_lock<mutex> lock(wake_mutex);
+  while (true) {
+    wake.wait_for(lock, opts.interval, [this] {
+      uint64_t claimed = head.load(memory_order_relaxed);
+      // after an error durable never catches up with wanted, and the
+      // waiters have been told, so that mustn't keep waking the flusher
+      return stopping ||
+             claimed - tail.load(memory_order_relaxed) >= opts.batch_bytes ||
+             (wanted.load(memory_order_relaxed) >
+                  durable.load(memory_order_relaxed) &&
+              error.load(memory_order_relaxed) == 0);
+    });
+    bool stop = stopping;
+    lock.unlock();
+    bool wrote = drain();
+    lock.lock();
+    durable_cv.notify_all();
+    // the producers have all finished by the time the destructor runs, so
+    // when there is nothing left the log is complete
+    if (stop && !wrote &&
+        tail.load(memory_order_relaxed) == head.load(memory_order_relaxed)) {
+      return;
+    }
+  }
+}
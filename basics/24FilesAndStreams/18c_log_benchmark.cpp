@@ -0,0 +1,209 @@
+/*
+--------------------------------
+Writing a Log: Benchmark
+--------------------------------
+- Lines of about 60 bytes written to a log file in each of the ways in
+  3StreamsAndBuffering.cpp, and with 18a_group_commit_log.h
+  * "ofstream": buffered by the stream
+  * "ofstream + flush": flush after every line
+  * "ofstream + fdatasync": flush and fdatasync after every line, which is
+    what it takes to have every line on the disk. It is so slow that it
+    only writes a few thousand lines
+  * "group_commit_log": from 1 thread, and from several at once
+  * "group_commit_log + sync": sync() after every 1000 lines
+- Each file is read back and checked: every thread's lines must all be
+  there, in the order that thread wrote them
+- Then the crash from 3StreamsAndBuffering.cpp: a child process writes
+  lines and calls terminate() at line 66666. The table shows how many lines
+  made it into the file. The buffered ofstream loses what was in its 8 KiB
+  buffer, group_commit_log what was still in its 64 KiB ring, which is at
+  most about 1000 of these lines
+
+build: g++ -std=c++20 -O3 -march=native 18b_group_commit_log.cpp \
+       18c_log_benchmark.cpp
+run:   ./a.out [lines] [threads]
+*/
+
+#include "18a_group_commit_log.h"
+
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <fcntl.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+const string filename = "/tmp/log_benchmark.txt";
+string note; // printed after the row
+
+string make_line(int thread, int i) {
+  return "thread " + to_string(thread) + " line " + to_string(i) +
+         ": the quick brown fox jumps\n";
+}
+
+// true if the file has lines 0 to lines - 1 from each thread, each
+// thread's in order
+bool check(int lines, int threads) {
+  ifstream ifile(filename);
+  vector<int> next(threads, 0);
+  string word, line;
+  int thread, i;
+  while (ifile >> word >> thread >> word >> i && getline(ifile, line)) {
+    if (thread < 0 || thread >= threads || next[thread] != i) {
+      return false;
+    }
+    ++next[thread];
+  }
+  for (int n : next) {
+    if (n != lines) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int count_lines() {
+  ifstream ifile(filename);
+  string line;
+  int count = 0;
+  while (getline(ifile, line)) {
+    ++count;
+  }
+  return count;
+}
+
+void write_ofstream(int lines, bool flush_lines, bool sync_lines) {
+  ofstream ofile(filename);
+  int fd = sync_lines ? ::open(filename.c_str(), O_WRONLY) : -1;
+  for (int i = 0; i < lines; ++i) {
+    ofile << make_line(0, i);
+    if (flush_lines) {
+      ofile << flush;
+    }
+    if (sync_lines) {
+      fdatasync(fd); // the ofstream has no way to get at its own descriptor
+    }
+  }
+  if (fd >= 0) {
+    ::close(fd);
+  }
+}
+
+void write_group_commit(int lines, int threads, int sync_every) {
+  group_commit_log log(filename);
+  vector<jthread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t] {
+      for (int i = 0; i < lines; ++i) {
+        log.append(make_line(t, i));
+        if (sync_every > 0 && (i + 1) % sync_every == 0) {
+          log.sync();
+        }
+      }
+    });
+  }
+  workers.clear(); // joins them
+  log.sync();
+  auto s = log.stats();
+  note = to_string(s.writes) + " writes, " + to_string(s.syncs) +
+         " syncs, " + to_string(s.waits) + " waits for space";
+}
+
+template <typename F> double time_it(F f) {
+  remove(filename.c_str());
+  auto start = steady_clock::now();
+  f();
+  duration<double> elapsed = steady_clock::now() - start;
+  return elapsed.count();
+}
+
+// the lines in the file after a child writes them and dies at line 66666
+template <typename F> int lines_after_crash(F write_line) {
+  remove(filename.c_str());
+  cout.flush(); // or the child prints it again
+  pid_t pid = fork();
+  if (pid == 0) {
+    // terminate()'s message would go in the middle of the table
+    if (!freopen("/dev/null", "w", stderr)) {
+      _exit(1);
+    }
+    write_line(); // doesn't return
+  }
+  int status;
+  waitpid(pid, &status, 0);
+  return count_lines();
+}
+
+int main(int argc, char *argv[]) {
+  int lines = argc > 1 ? stoi(argv[1]) : 1000000;
+  int threads = argc > 2 ? stoi(argv[2]) : 4;
+
+  cout << setw(34) << "" << setw(10) << "lines" << setw(14) << "lines/s"
+       << setw(8) << "ok" << "\n";
+  auto row = [&](const string &name, int count, int producers, auto f) {
+    double seconds = time_it(f);
+    double total = static_cast<double>(count) * producers;
+    cout << setw(34) << name << setw(10) << count * producers << setw(14)
+         << fixed << setprecision(0) << total / seconds << defaultfloat
+         << setw(8) << (check(count, producers) ? "yes" : "NO") << "\n";
+    if (!note.empty()) {
+      cout << setw(34) << "" << "  " << note << "\n";
+      note.clear();
+    }
+  };
+  int few = min(lines, 2000);
+  row("ofstream", lines, 1, [&] { write_ofstream(lines, false, false); });
+  row("ofstream + flush", lines, 1,
+      [&] { write_ofstream(lines, true, false); });
+  row("ofstream + fdatasync", few, 1,
+      [&] { write_ofstream(few, true, true); });
+  row("group_commit_log, 1 thread", lines, 1,
+      [&] { write_group_commit(lines, 1, 0); });
+  row("group_commit_log, " + to_string(threads) + " threads",
+      lines / threads, threads,
+      [&] { write_group_commit(lines / threads, threads, 0); });
+  row("group_commit_log + sync, 1 thread", lines, 1,
+      [&] { write_group_commit(lines, 1, 1000); });
+
+  cout << "\nlines in the file after terminate() at line 66666\n";
+  cout << setw(34) << "ofstream" << setw(10) << lines_after_crash([] {
+    ofstream ofile(filename);
+    for (int i = 0;; ++i) {
+      ofile << make_line(0, i);
+      if (i == 66666) {
+        terminate();
+      }
+    }
+  }) << "\n";
+  cout << setw(34) << "group_commit_log" << setw(10) << lines_after_crash([] {
+    group_commit_log log(filename);
+    for (int i = 0;; ++i) {
+      log.append(make_line(0, i));
+      if (i == 66666) {
+        terminate();
+      }
+    }
+  }) << "\n";
+  cout << setw(34) << "group_commit_log + sync" << setw(10)
+       << lines_after_crash([] {
+            group_commit_log log(filename);
+            for (int i = 0;; ++i) {
+              log.append(make_line(0, i));
+              if (i == 66666) {
+                log.sync();
+                terminate();
+              }
+            }
+          })
+       << "\n";
+  remove(filename.c_str());
+}
@@ -0,0 +1,284 @@
+#ifndef RECORD_FILE_H
+#define RECORD_FILE_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+
+/*
+A file of fixed size binary records
+- 14BinaryFiles.cpp writes one #pragma pack(1) point with ofstream::write
+  and reads it back with ifstream::read. record_file<T> does that for a
+  whole file of them
+    #pragma pack(push, 1)
+    struct point { char c; int32_t x; int32_t y; };
+    #pragma pack(pop)
+    record_file<point> points("points.bin");
+    points.append({'a', 1, 2});
+- T must be trivially copyable, as its bytes are what goes in the file
+- The file starts with a 16 byte header: "RECORDS", a version and
+  sizeof(T). Opening a file of some other record size throws, rather than
+  reading garbage. The records follow the header, so record i is at byte
+  16 + i * sizeof(T) and there is no need to seek around as
+  12RandomAccessToStreams.cpp does
+- append() only adds to the end, and collects the records in memory first.
+  They are written batch records at a time, with one write(), or by
+  flush() and the destructor. A record which has been appended but not
+  written can still be read
+- Reading
+  * read(i) is one pread() of record i, read(first, out) fills out with
+    one pread(). Neither moves a file position, so threads can share them
+  * records() maps the file into memory and gives the records written so
+    far as a span, with no copying at all. Record i is records()[i]. The
+    span is valid until the next call which writes or maps the file again
+- Throws std::runtime_error if the file can't be opened, read or written,
+  and std::out_of_range for an index past the end
+*/
+
+template <typename T> class record_file {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "records are written as their bytes");
+
+  struct file_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+  };
+  static_assert(sizeof(file_header) == 16);
+  static_assert(alignof(T) <= sizeof(file_header),
+                "the records in a mapping must be aligned");
+
+  static constexpr char magic[8] = "RECORDS";
+  static constexpr uint32_t version = 1;
+  static constexpr size_t header_size = sizeof(file_header);
+
+  std::string filename;
+  int fd{-1};
+  size_t written{0}; // records in the file
+  std::vector<T> pending;
+  size_t batch;
+
+  const char *map{nullptr};
+  size_t map_size{0};
+
+  std::runtime_error io_error(int err) const {
+    return std::runtime_error(filename + ": " + std::strerror(err));
+  }
+
+  void unmap() {
+    if (map) {
+      munmap(const_cast<char *>(map), map_size);
+      map = nullptr;
+      map_size = 0;
+    }
+  }
+
+  void close() {
+    unmap();
+    if (fd >= 0) {
+      ::close(fd);
+      fd = -1;
+    }
+  }
+
+  void write_all(const void *data, size_t size) {
+    auto p = static_cast<const char *>(data);
+    while (size > 0) {
+      ssize_t n = ::write(fd, p, size);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throw io_error(errno);
+      }
+      p += n;
+      size -= static_cast<size_t>(n);
+    }
+  }
+
+  void read_all(void *data, size_t size, off_t offset) const {
+    auto p = static_cast<char *>(data);
+    while (size > 0) {
+      ssize_t n = ::pread(fd, p, size, offset);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throw io_error(errno);
+      }
+      if (n == 0) {
+        throw std::runtime_error(filename + ": shorter than expected");
+      }
+      p += n;
+      size -= static_cast<size_t>(n);
+      offset += n;
+    }
+  }
+
+  static off_t offset_of(size_t index) {
+    return static_cast<off_t>(header_size + index * sizeof(T));
+  }
+
+  void open(const std::string &name) {
+    fd = ::open(name.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+      throw io_error(errno);
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0) {
+      throw io_error(errno);
+    }
+    auto size = static_cast<size_t>(st.st_size);
+    if (size == 0) {
+      file_header header{};
+      std::memcpy(header.magic, magic, sizeof magic);
+      header.version = version;
+      header.record_size = sizeof(T);
+      write_all(&header, sizeof header);
+      return;
+    }
+    file_header header{};
+    if (size < header_size) {
+      throw std::runtime_error(name + ": not a record file");
+    }
+    read_all(&header, sizeof header, 0);
+    if (std::memcmp(header.magic, magic, sizeof magic) != 0 ||
+        header.version != version) {
+      throw std::runtime_error(name + ": not a record file");
+    }
+    if (header.record_size != sizeof(T)) {
+      throw std::runtime_error(name + ": records of " +
+                               std::to_string(header.record_size) +
+                               " bytes, not " + std::to_string(sizeof(T)));
+    }
+    // a record cut short by a crash is left out, and written over
+    written = (size - header_size) / sizeof(T);
+    if (ftruncate(fd, offset_of(written)) != 0) {
+      throw io_error(errno);
+    }
+  }
+
+public:
+  explicit record_file(const std::string &filename, size_t batch = 4096)
+      : filename(filename), batch(std::max<size_t>(batch, 1)) {
+    try {
+      open(filename);
+    } catch (...) {
+      close();
+      throw;
+    }
+    pending.reserve(this->batch);
+  }
+  ~record_file() {
+    try {
+      flush();
+    } catch (...) {
+      // nothing can be done about it here, call flush() to find out
+    }
+    close();
+  }
+
+  record_file(const record_file &) = delete;
+  record_file &operator=(const record_file &) = delete;
+
+  size_t size() const { return written + pending.size(); }
+
+  void append(const T &record) {
+    pending.push_back(record);
+    if (pending.size() >= batch) {
+      flush();
+    }
+  }
+
+  // a big batch goes straight to the file
+  void append(std::span<const T> records) {
+    if (pending.size() + records.size() < batch) {
+      pending.insert(pending.end(), records.begin(), records.end());
+      return;
+    }
+    flush();
+    write_all(records.data(), records.size_bytes());
+    written += records.size();
+  }
+
+  void flush() {
+    if (pending.empty()) {
+      return;
+    }
+    write_all(pending.data(), pending.size() * sizeof(T));
+    written += pending.size();
+    pending.clear();
+  }
+
+  T read(size_t index) const {
+    if (index >= size()) {
+      throw std::out_of_range(filename + ": no record " +
+                              std::to_string(index));
+    }
+    if (index >= written) {
+      return pending[index - written];
+    }
+    T record;
+    read_all(&record, sizeof record, offset_of(index));
+    return record;
+  }
+
+  // reads out.size() records, from record first on
+  void read(size_t first, std::span<T> out) const {
+    if (first > size() || out.size() > size() - first) {
+      throw std::out_of_range(filename + ": no record " +
+                              std::to_string(size()));
+    }
+    size_t from_file = first < written ? std::min(written - first, out.size())
+                                       : 0;
+    if (from_file > 0) {
+      read_all(out.data(), from_file * sizeof(T), offset_of(first));
+    }
+    if (from_file < out.size()) {
+      std::copy(pending.begin() + (first + from_file - written),
+                pending.begin() + (first + out.size() - written),
+                out.begin() + from_file);
+    }
+  }
+
+  // every record written to the file, mapped into memory
+  std::span<const T> records() {
+    flush();
+    size_t bytes = static_cast<size_t>(offset_of(written));
+    if (written == 0) {
+      return {};
+    }
+    if (map_size != bytes) {
+      unmap();
+      void *addr = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+      if (addr == MAP_FAILED) {
+        throw io_error(errno);
+      }
+      map = static_cast<const char *>(addr);
+      map_size = bytes;
+    }
+    return {reinterpret_cast<const T *>(map + header_size), written};
+  }
+
+  std::span<const T> records(size_t first, size_t count) {
+    std::span<const T> all = records();
+    if (first > all.size() || count > all.size() - first) {
+      throw std::out_of_range(filename + ": no record " +
+                              std::to_string(all.size()));
+    }
+    return all.subspan(first, count);
+  }
+};
+
+#endif // RECORD_FILE_H
@@ -0,0 +1,257 @@
+/*
+--------------------------------
+Binary Records: Benchmark
+--------------------------------
+- Checks first, on a small file with a batch of 4: reading across the
+  records in the file and those still pending, reopening, a few bytes of
+  garbage on the end as a crash would leave, and opening it as the wrong
+  record type
+- A file of packed 25 byte trade records, written with record_file from
+  19a_record_file.h and with ofstream::write a record at a time as in
+  14BinaryFiles.cpp
+- Then read in three ways, at random and from start to end
+  * "ifstream": seekg to the record and read it, as 12RandomAccessToStreams.cpp
+    does with a stringstream
+  * "pread": record_file::read(), one record at a time for the random
+    reads, 4096 at a time for the sequential ones
+  * "mmap": record_file::records(), no copying at all
+- Every way must add up to the same sum
+- The file is in the page cache, so this is the cost of getting at the
+  records, not of the disk
+- The file goes in the system temporary directory and is removed afterwards
+
+build: g++ -std=c++20 -O3 -march=native 19b_record_file_benchmark.cpp
+run:   ./a.out [records]
+*/
+
+#include "19a_record_file.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+#pragma pack(push, 1)
+struct trade {
+  char side;
+  int32_t id;
+  int64_t time;
+  double price;
+  int32_t quantity;
+};
+#pragma pack(pop)
+
+const size_t header = 16; // record_file's
+
+trade make_trade(size_t i) {
+  return {i % 3 == 0 ? 's' : 'b', static_cast<int32_t>(i),
+          static_cast<int64_t>(i) * 1000, 100.0 + i % 97,
+          static_cast<int32_t>(i % 1000)};
+}
+
+bool same_trade(const trade &a, const trade &b) {
+  return memcmp(&a, &b, sizeof a) == 0;
+}
+
+// true if the file holds trades 0 to n - 1 and nothing else
+bool has_trades(const record_file<trade> &trades, size_t n) {
+  bool same = trades.size() == n;
+  for (size_t i = 0; same && i < n; ++i) {
+    same = same_trade(trades.read(i), make_trade(i));
+  }
+  return same;
+}
+
+bool checks(const filesystem::path &dir) {
+  bool ok = true;
+  auto check = [&ok](const char *what, bool passed) {
+    cout << setw(44) << left << what << (passed ? "yes" : "NO") << right
+         << "\n";
+    ok = ok && passed;
+  };
+
+  string file = (dir / "trades_check.bin").string();
+  filesystem::remove(file);
+  {
+    record_file<trade> trades(file, 4);
+    for (size_t i = 0; i < 10; ++i) {
+      trades.append(make_trade(i));
+    }
+    // 8 of them written and 2 pending, read from 5 on
+    bool split = filesystem::file_size(file) == header + 8 * sizeof(trade);
+    vector<trade> out(5);
+    trades.read(5, out);
+    for (size_t i = 0; i < out.size(); ++i) {
+      split = split && same_trade(out[i], make_trade(5 + i));
+    }
+    check("read() across written and pending records", split);
+  }
+  check("reopened with every record", has_trades(record_file<trade>(file), 10));
+
+  // half a record on the end, as a crash in the middle of a write leaves
+  {
+    ofstream ofile(file, fstream::binary | fstream::app);
+    ofile.write("garbage", 7);
+  }
+  {
+    record_file<trade> trades(file);
+    check("garbage on the end is left out", has_trades(trades, 10));
+    trades.append(make_trade(10));
+  }
+  check("and written over by the next record",
+        has_trades(record_file<trade>(file), 11) &&
+            filesystem::file_size(file) == header + 11 * sizeof(trade));
+
+  bool refused = false;
+  try {
+    record_file<int> ints(file);
+  } catch (const runtime_error &e) {
+    refused = string(e.what()).find("records of 25 bytes") != string::npos;
+  }
+  check("opening it as int records is refused", refused);
+  filesystem::remove(file);
+  cout << "\n";
+  return ok;
+}
+
+template <typename F> double time_it(F f) {
+  auto start = steady_clock::now();
+  f();
+  duration<double> elapsed = steady_clock::now() - start;
+  return elapsed.count();
+}
+
+int main(int argc, char *argv[]) {
+  size_t count = argc > 1 ? stoul(argv[1]) : 4000000;
+  if (count == 0) {
+    cerr << "records must be at least 1\n";
+    return 1;
+  }
+  filesystem::path dir = filesystem::temp_directory_path();
+  if (!checks(dir)) {
+    return 1;
+  }
+  const size_t block = 4096;
+  const string filename = (dir / "trades.bin").string();
+
+  cout << count << " records of " << sizeof(trade) << " bytes\n\n";
+  cout << setw(20) << "" << setw(16) << "M records/s" << setw(8) << "same"
+       << "\n";
+  auto row = [](const string &name, double seconds, size_t n, bool same) {
+    cout << setw(20) << name << setw(16) << fixed << setprecision(1)
+         << n / seconds / 1e6 << defaultfloat << setw(8)
+         << (same ? "yes" : "NO") << "\n";
+  };
+
+  cout << "writing\n";
+  remove(filename.c_str());
+  double seconds = time_it([&] {
+    ofstream ofile(filename, fstream::binary);
+    char h[header] = {};
+    ofile.write(h, header);
+    for (size_t i = 0; i < count; ++i) {
+      trade t = make_trade(i);
+      ofile.write(reinterpret_cast<char *>(&t), sizeof t);
+    }
+  });
+  row("ofstream", seconds, count, true);
+  remove(filename.c_str());
+  seconds = time_it([&] {
+    record_file<trade> trades(filename);
+    for (size_t i = 0; i < count; ++i) {
+      trades.append(make_trade(i));
+    }
+  });
+  row("record_file", seconds, count, true);
+
+  record_file<trade> trades(filename);
+  ifstream ifile(filename, fstream::binary);
+
+  mt19937 rng(1);
+  uniform_int_distribution<size_t> pick(0, count - 1);
+  vector<size_t> indices(count);
+  for (size_t &i : indices) {
+    i = pick(rng);
+  }
+  int64_t expected = 0;
+  for (size_t i : indices) {
+    expected += make_trade(i).quantity;
+  }
+
+  cout << "random reads\n";
+  int64_t sum = 0;
+  seconds = time_it([&] {
+    trade t;
+    for (size_t i : indices) {
+      ifile.seekg(static_cast<streamoff>(header + i * sizeof t));
+      ifile.read(reinterpret_cast<char *>(&t), sizeof t);
+      sum += t.quantity;
+    }
+  });
+  row("ifstream", seconds, count, sum == expected);
+  sum = 0;
+  seconds = time_it([&] {
+    for (size_t i : indices) {
+      sum += trades.read(i).quantity;
+    }
+  });
+  row("pread", seconds, count, sum == expected);
+  sum = 0;
+  seconds = time_it([&] {
+    span<const trade> all = trades.records();
+    for (size_t i : indices) {
+      sum += all[i].quantity;
+    }
+  });
+  row("mmap", seconds, count, sum == expected);
+
+  expected = 0;
+  for (size_t i = 0; i < count; ++i) {
+    expected += make_trade(i).quantity;
+  }
+
+  cout << "sequential reads\n";
+  sum = 0;
+  seconds = time_it([&] {
+    trade t;
+    for (size_t i = 0; i < count; ++i) {
+      ifile.seekg(static_cast<streamoff>(header + i * sizeof t));
+      ifile.read(reinterpret_cast<char *>(&t), sizeof t);
+      sum += t.quantity;
+    }
+  });
+  row("ifstream", seconds, count, sum == expected);
+  sum = 0;
+  seconds = time_it([&] {
+    vector<trade> buffer(block);
+    for (size_t first = 0; first < count; first += block) {
+      span<trade> out(buffer.data(), min(block, count - first));
+      trades.read(first, out);
+      for (const trade &t : out) {
+        sum += t.quantity;
+      }
+    }
+  });
+  row("pread", seconds, count, sum == expected);
+  sum = 0;
+  seconds = time_it([&] {
+    for (const trade &t : trades.records()) {
+      sum += t.quantity;
+    }
+  });
+  row("mmap", seconds, count, sum == expected);
+
+  remove(filename.c_str());
+}
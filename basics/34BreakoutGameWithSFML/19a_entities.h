@@ -0,0 +1,472 @@
+#ifndef BREAKOUT_ENTITIES_H
+#define BREAKOUT_ENTITIES_H
+
+/*
+------------------------------
+ Breakout Entities, Headless
+------------------------------
+- The entity classes and entity_manager from the lessons, without SFML
+  * Instead of an sf::Sprite, each entity has a position and a size, which
+    is all the game logic looks at
+  * The sprite colour of a brick is kept as a plain RGBA value
+  * The paddle is moved by calling move_left()/move_right()/stop() instead
+    of reading the keyboard
+- This is the pointer-based design from 13EntityManagerOverview.cpp
+  * Every entity is a separate object, and update() is a virtual call
+- It is the baseline the data-oriented entity manager is measured against
+- One change from the lessons: the groups are not found by type_info
+  * The lessons key grouped_entities on type_info::hash_code(), which is a
+    map lookup every time a group is used, and apply_all() does a
+    dynamic_cast on every element
+  * Instead the manager is given the list of entity types when it is
+    declared, and each type's group is the array element at its position in
+    the list, which is known at compile time
+  * A group only ever holds entities of exactly its type, so apply_all() can
+    static_cast, which costs nothing
+  * Asking for a type which is not in the list is a compile error
+- Another: refresh() doesn't shift anything or go back to the heap
+  * The lessons erase destroyed entities from all_entities and from every
+    group vector, moving everything after them down, and the unique_ptrs
+    give their memory back to the heap, which create() then asks for again
+  * Here each destroyed entity is swap-and-popped out of all_entities and
+    its group in the same pass, and its storage goes back to a pool for its
+    type, to be reused by the next create()
+  * So the order of the entities in all_entities and in the groups changes
+    as entities are destroyed, which the game doesn't depend on
+*/
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+struct constants {
+  static constexpr float window_width{520.0f};
+  static constexpr float window_height{450.0f};
+  static constexpr float ball_size{16.0f};
+  static constexpr float ball_speed{6.0f};
+  static constexpr float paddle_width{60.0f};
+  static constexpr float paddle_height{20.0f};
+  static constexpr float paddle_speed{6.0f};
+  static constexpr float brick_width{43.0f};
+  static constexpr float brick_height{20.0f};
+  static constexpr float brick_offset{brick_width / 2.0f};
+  static constexpr int brick_columns{10};
+  static constexpr int brick_rows{4};
+  static constexpr int brick_strength{3};
+};
+
+// a list of types, and the position of each type in it
+template <typename... Types> struct type_list {
+  static constexpr size_t size = sizeof...(Types);
+
+  // size if T is not in the list
+  template <typename T> static constexpr size_t index_of() {
+    constexpr bool matches[]{std::is_same_v<T, Types>...};
+    for (size_t i = 0; i < size; ++i) {
+      if (matches[i]) {
+        return i;
+      }
+    }
+    return size;
+  }
+};
+
+struct vec2 {
+  float x{0.0f};
+  float y{0.0f};
+};
+
+// the colour of a brick for each strength, as in 16BrickStrength.cpp
+// the weaker the brick, the more transparent it is
+inline uint32_t brick_colour(int strength) {
+  uint32_t alpha = strength >= 3 ? 255 : strength == 2 ? 170 : 85;
+  return 0x00ff00u | alpha << 24; // green
+}
+
+//-------------------------------
+// entity
+//-------------------------------
+class entity {
+protected:
+  vec2 position; // top left corner
+  vec2 size;
+  bool destroyed{false};
+
+public:
+  entity(float x, float y, float width, float height)
+      : position{x, y}, size{width, height} {}
+  virtual ~entity() = default;
+
+  virtual void update() = 0;
+
+  vec2 get_position() const noexcept { return position; }
+  vec2 get_size() const noexcept { return size; }
+  void set_position(float x, float y) noexcept { position = {x, y}; }
+  float x() const noexcept { return position.x + size.x / 2.0f; } // centre
+  float y() const noexcept { return position.y + size.y / 2.0f; }
+  float left() const noexcept { return position.x; }
+  float right() const noexcept { return position.x + size.x; }
+  float top() const noexcept { return position.y; }
+  float bottom() const noexcept { return position.y + size.y; }
+
+  bool is_destroyed() const noexcept { return destroyed; }
+  void destroy() noexcept { destroyed = true; }
+};
+
+//-------------------------------
+// moving_entity
+//-------------------------------
+class moving_entity : public entity {
+protected:
+  vec2 velocity;
+
+public:
+  using entity::entity;
+
+  vec2 get_velocity() const noexcept { return velocity; }
+
+  virtual void move_up() noexcept = 0;
+  virtual void move_down() noexcept = 0;
+  virtual void move_left() noexcept = 0;
+  virtual void move_right() noexcept = 0;
+};
+
+//-------------------------------
+// ball
+//-------------------------------
+class ball : public moving_entity {
+public:
+  ball(float x, float y)
+      : moving_entity(x, y, constants::ball_size, constants::ball_size) {
+    velocity = {constants::ball_speed, constants::ball_speed};
+  }
+
+  // bounces off the sides and the top, and is lost off the bottom
+  void update() override {
+    position.x += velocity.x;
+    position.y += velocity.y;
+    if (left() < 0.0f || right() > constants::window_width) {
+      velocity.x = -velocity.x;
+    }
+    if (top() < 0.0f) {
+      velocity.y = -velocity.y;
+    }
+    if (top() > constants::window_height) {
+      destroy();
+    }
+  }
+
+  void move_up() noexcept override { velocity.y = -constants::ball_speed; }
+  void move_down() noexcept override { velocity.y = constants::ball_speed; }
+  void move_left() noexcept override { velocity.x = -constants::ball_speed; }
+  void move_right() noexcept override { velocity.x = constants::ball_speed; }
+};
+
+//-------------------------------
+// paddle
+//-------------------------------
+class paddle : public moving_entity {
+public:
+  paddle(float x, float y)
+      : moving_entity(x, y, constants::paddle_width,
+                      constants::paddle_height) {}
+
+  // moves sideways, and stops at the edges of the window
+  void update() override {
+    position.x += velocity.x;
+    position.x = std::clamp(position.x, 0.0f,
+                            constants::window_width - constants::paddle_width);
+  }
+
+  void move_up() noexcept override {}
+  void move_down() noexcept override {}
+  void move_left() noexcept override {
+    velocity.x = -constants::paddle_speed;
+  }
+  void move_right() noexcept override {
+    velocity.x = constants::paddle_speed;
+  }
+  void stop() noexcept { velocity.x = 0.0f; }
+};
+
+//-------------------------------
+// brick
+//-------------------------------
+class brick : public entity {
+  int strength{constants::brick_strength};
+  uint32_t colour{brick_colour(constants::brick_strength)};
+
+public:
+  brick(float x, float y)
+      : entity(x, y, constants::brick_width, constants::brick_height) {}
+
+  // the colour depends on how many hits the brick has left
+  void update() override { colour = brick_colour(strength); }
+
+  void set_strength(int s) noexcept { strength = s; }
+  void weaken() noexcept { --strength; }
+  bool is_too_weak() const noexcept { return strength <= 0; }
+  int get_strength() const noexcept { return strength; }
+  uint32_t get_colour() const noexcept { return colour; }
+};
+
+//-------------------------------
+// collisions
+//-------------------------------
+// true if the bounding boxes overlap
+inline bool is_interacting(const entity &e1, const entity &e2) {
+  return e1.right() >= e2.left() && e1.left() <= e2.right() &&
+         e1.bottom() >= e2.top() && e1.top() <= e2.bottom();
+}
+
+// the ball bounces up, and to the side of the paddle it hit
+inline void handle_collision(ball &b, const paddle &p) {
+  if (is_interacting(p, b)) {
+    b.move_up();
+    if (b.x() < p.x()) {
+      b.move_left();
+    } else {
+      b.move_right();
+    }
+  }
+}
+
+// the brick is weakened, and the ball bounces off the side it hit, worked
+// out from the overlaps as in 11BallInteractionWithBricks.cpp
+inline void handle_collision(ball &the_ball, brick &the_brick) {
+  if (!is_interacting(the_ball, the_brick)) {
+    return;
+  }
+  the_brick.weaken();
+  if (the_brick.is_too_weak()) {
+    the_brick.destroy();
+  }
+
+  float left_overlap = the_ball.right() - the_brick.left();
+  float right_overlap = the_brick.right() - the_ball.left();
+  float top_overlap = the_ball.bottom() - the_brick.top();
+  float bottom_overlap = the_brick.bottom() - the_ball.top();
+
+  bool from_left = std::abs(left_overlap) < std::abs(right_overlap);
+  bool from_top = std::abs(top_overlap) < std::abs(bottom_overlap);
+  float min_x_overlap = from_left ? left_overlap : right_overlap;
+  float min_y_overlap = from_top ? top_overlap : bottom_overlap;
+
+  if (std::abs(min_x_overlap) < std::abs(min_y_overlap)) {
+    if (from_left) {
+      the_ball.move_left();
+    } else {
+      the_ball.move_right();
+    }
+  } else {
+    if (from_top) {
+      the_ball.move_up();
+    } else {
+      the_ball.move_down();
+    }
+  }
+}
+
+//-------------------------------
+// entity_pool
+//-------------------------------
+// storage for entities of one type, allocated from the heap a chunk at a
+// time. A released entity's storage goes on a free list and is handed out
+// again by the next allocate(), so once the game has warmed up creating and
+// destroying entities doesn't touch the heap at all
+class entity_pool_base {
+public:
+  virtual ~entity_pool_base() = default;
+  virtual void release(entity *e) = 0;
+};
+
+template <typename T> class entity_pool : public entity_pool_base {
+  union slot {
+    slot *next;
+    alignas(T) std::byte storage[sizeof(T)];
+  };
+  static constexpr size_t chunk_size = 256;
+
+  std::vector<std::unique_ptr<slot[]>> chunks;
+  slot *free_list{nullptr};
+
+public:
+  template <typename... Args> T *allocate(Args &&...args) {
+    if (!free_list) {
+      chunks.push_back(std::make_unique<slot[]>(chunk_size));
+      slot *chunk = chunks.back().get();
+      for (size_t i = 0; i < chunk_size; ++i) {
+        chunk[i].next = i + 1 < chunk_size ? &chunk[i + 1] : nullptr;
+      }
+      free_list = chunk;
+    }
+    // the entity is built over next, so read it first, but only take the
+    // slot off the list once the constructor hasn't thrown
+    slot *s = free_list;
+    slot *next = s->next;
+    T *p = ::new (static_cast<void *>(s->storage))
+        T(std::forward<Args>(args)...);
+    free_list = next;
+    return p;
+  }
+
+  void release(entity *e) override {
+    auto p = static_cast<T *>(e);
+    p->~T();
+    slot *s = reinterpret_cast<slot *>(p);
+    s->next = free_list;
+    free_list = s;
+  }
+
+  size_t chunk_count() const { return chunks.size(); }
+};
+
+//-------------------------------
+// entity_manager
+//-------------------------------
+// Types is a type_list of the entity types the manager can hold
+// Entities live in a pool for their type and the manager owns them, so
+// all_entities holds plain pointers, along with where each entity's alias is
+// in grouped_entities. group_owners[g][i] is the all_entities index of the
+// entity grouped_entities[g][i] points to. These let refresh() remove an
+// entity from both vectors with swap-and-pop and fix up whatever was moved
+template <typename Types> class basic_entity_manager {
+  struct entity_record {
+    entity *ptr;
+    uint32_t group;       // which group its alias is in
+    uint32_t group_index; // and where
+  };
+  using entity_alias_vector = std::vector<entity *>;
+
+  std::vector<entity_record> all_entities;
+  std::array<entity_alias_vector, Types::size> grouped_entities;
+  std::array<std::vector<uint32_t>, Types::size> group_owners;
+  std::array<std::unique_ptr<entity_pool_base>, Types::size> pools;
+
+  template <typename T> static constexpr size_t group() {
+    constexpr size_t index = Types::template index_of<T>();
+    static_assert(index < Types::size,
+                  "this entity type is not one of the manager's types");
+    return index;
+  }
+
+  template <typename T> entity_pool<T> &pool() {
+    auto &p = pools[group<T>()];
+    if (!p) {
+      p = std::make_unique<entity_pool<T>>();
+    }
+    return static_cast<entity_pool<T> &>(*p);
+  }
+
+  // reserve() on its own would grow v by one element at a time
+  template <typename V> static void make_room(V &v) {
+    if (v.size() == v.capacity()) {
+      v.reserve(std::max<size_t>(16, v.size() * 2));
+    }
+  }
+
+  // swap-and-pop the alias at index i of group g
+  void remove_alias(uint32_t g, uint32_t i) {
+    auto &aliases = grouped_entities[g];
+    auto &owners = group_owners[g];
+    aliases[i] = aliases.back();
+    owners[i] = owners.back();
+    all_entities[owners[i]].group_index = i;
+    aliases.pop_back();
+    owners.pop_back();
+  }
+
+public:
+  basic_entity_manager() = default;
+  basic_entity_manager(const basic_entity_manager &) = delete;
+  basic_entity_manager &operator=(const basic_entity_manager &) = delete;
+  ~basic_entity_manager() { clear(); }
+
+  template <typename T, typename... Args> T &create(Args &&...args) {
+    static_assert(std::is_base_of_v<entity, T>,
+                  "entity_manager can only create entities");
+    constexpr uint32_t g = group<T>();
+    // make room first, so nothing can throw once the entity exists
+    make_room(all_entities);
+    make_room(grouped_entities[g]);
+    make_room(group_owners[g]);
+
+    T *alias = pool<T>().allocate(std::forward<Args>(args)...);
+    uint32_t index = static_cast<uint32_t>(all_entities.size());
+    all_entities.push_back(
+        {alias, g, static_cast<uint32_t>(grouped_entities[g].size())});
+    grouped_entities[g].push_back(alias);
+    group_owners[g].push_back(index);
+    return *alias;
+  }
+
+  // delete the destroyed entities in one pass over all_entities
+  // a destroyed entity's alias is swap-and-popped out of its group, its
+  // storage goes back to the pool, and the last entity moves into its place
+  // in all_entities, which is then checked in turn
+  void refresh() {
+    size_t i = 0;
+    while (i < all_entities.size()) {
+      entity_record record = all_entities[i];
+      if (!record.ptr->is_destroyed()) {
+        ++i;
+        continue;
+      }
+      remove_alias(record.group, record.group_index);
+      pools[record.group]->release(record.ptr);
+
+      all_entities[i] = all_entities.back();
+      all_entities.pop_back();
+      if (i < all_entities.size()) {
+        const entity_record &moved = all_entities[i];
+        group_owners[moved.group][moved.group_index] =
+            static_cast<uint32_t>(i);
+      }
+    }
+  }
+
+  void clear() {
+    for (auto &record : all_entities) {
+      pools[record.group]->release(record.ptr);
+    }
+    all_entities.clear();
+    for (size_t g = 0; g < Types::size; ++g) {
+      grouped_entities[g].clear();
+      group_owners[g].clear();
+    }
+  }
+
+  template <typename T> auto &get_all() {
+    return grouped_entities[group<T>()];
+  }
+
+  // everything in T's group was created as a T
+  template <typename T, typename Func> void apply_all(const Func &func) {
+    auto &entity_group = get_all<T>();
+    for (auto ptr : entity_group) {
+      func(*static_cast<T *>(ptr));
+    }
+  }
+
+  void update() {
+    for (auto &record : all_entities) {
+      record.ptr->update();
+    }
+  }
+
+  size_t size() const { return all_entities.size(); }
+
+  // chunks of entity storage taken from the heap so far
+  template <typename T> size_t pool_chunks() { return pool<T>().chunk_count(); }
+};
+
+using entity_manager = basic_entity_manager<type_list<ball, paddle, brick>>;
+
+#endif // BREAKOUT_ENTITIES_H
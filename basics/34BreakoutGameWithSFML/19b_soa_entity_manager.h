@@ -0,0 +1,350 @@
+#ifndef BREAKOUT_SOA_ENTITY_MANAGER_H
+#define BREAKOUT_SOA_ENTITY_MANAGER_H
+
+/*
+-------------------------------------
+ Data-Oriented Entity Manager (SoA)
+-------------------------------------
+- 18Conclusion.cpp lists what makes the pointer-based design slow:
+  vector reallocation, virtual calls, RTTI and poor cache locality
+- Here an entity is not an object at all. It is a row in a table of
+  components, and there is one table for each type of entity
+  * Each component is its own array: all the x positions together, all the
+    y positions together, and so on (structure of arrays)
+  * Updating every ball is a loop down a few arrays of floats, with no
+    pointers to follow and nothing virtual, which the compiler can vectorize
+- The components are the ones the game uses
+  * position, velocity, sprite bounds (width and height), sprite colour
+  * strength, which is only used by bricks
+- An entity type is a small struct with a spawn() function, which sets up
+  the components of a new entity from the arguments of create()
+- The same interface as the lessons
+    manager.create<ball>(x, y);
+    manager.apply_all<brick>([](auto b) { ... });
+  apply_all passes an entity_ref, a table and a row, with accessors for the
+  components. get_all<T>() gives the table itself, for loops over whole
+  arrays
+- Entity handles
+  * Rows move when entities are removed, so nothing outside the manager can
+    hold on to a row
+  * create() returns a handle instead: an index into a slot table which
+    always knows the entity's current table and row
+  * Each slot has a generation, which goes up when its entity is removed, so
+    a handle to a removed entity is recognised as stale even after the slot
+    has been reused
+- refresh() removes destroyed entities by moving the last row of the table
+  into the hole, so nothing is shifted, and fixes the moved entity's slot
+- The tables are an array indexed by each type's position in the manager's
+  type_list, as with the pointer-based manager, so finding a table is free
+*/
+
+#include "19a_entities.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace soa {
+
+struct entity_handle {
+  uint32_t slot{UINT32_MAX};
+  uint32_t generation{0};
+};
+
+// the components of every entity of one type
+struct entity_table {
+  std::vector<float> x, y;          // top left corner
+  std::vector<float> vx, vy;        // velocity
+  std::vector<float> width, height; // sprite bounds
+  std::vector<uint32_t> colour;     // sprite colour
+  std::vector<int> strength;
+  std::vector<uint8_t> destroyed;
+  std::vector<uint32_t> slot; // the handle slot which points at each row
+
+  size_t size() const { return x.size(); }
+
+  void push_back(uint32_t slot_index) {
+    x.push_back(0.0f);
+    y.push_back(0.0f);
+    vx.push_back(0.0f);
+    vy.push_back(0.0f);
+    width.push_back(0.0f);
+    height.push_back(0.0f);
+    colour.push_back(0);
+    strength.push_back(0);
+    destroyed.push_back(0);
+    slot.push_back(slot_index);
+  }
+
+  // move the last row into row, and drop the last row
+  void swap_and_pop(size_t row) {
+    size_t last = size() - 1;
+    x[row] = x[last];
+    y[row] = y[last];
+    vx[row] = vx[last];
+    vy[row] = vy[last];
+    width[row] = width[last];
+    height[row] = height[last];
+    colour[row] = colour[last];
+    strength[row] = strength[last];
+    destroyed[row] = destroyed[last];
+    slot[row] = slot[last];
+    x.pop_back();
+    y.pop_back();
+    vx.pop_back();
+    vy.pop_back();
+    width.pop_back();
+    height.pop_back();
+    colour.pop_back();
+    strength.pop_back();
+    destroyed.pop_back();
+    slot.pop_back();
+  }
+
+  void clear() {
+    x.clear();
+    y.clear();
+    vx.clear();
+    vy.clear();
+    width.clear();
+    height.clear();
+    colour.clear();
+    strength.clear();
+    destroyed.clear();
+    slot.clear();
+  }
+};
+
+// one entity: a row of a table
+// only valid until the next create(), refresh() or clear()
+class entity_ref {
+  entity_table *table;
+  size_t row;
+
+public:
+  entity_ref(entity_table &table, size_t row) : table(&table), row(row) {}
+
+  float &x() { return table->x[row]; }
+  float &y() { return table->y[row]; }
+  float &vx() { return table->vx[row]; }
+  float &vy() { return table->vy[row]; }
+  float &width() { return table->width[row]; }
+  float &height() { return table->height[row]; }
+  uint32_t &colour() { return table->colour[row]; }
+  int &strength() { return table->strength[row]; }
+
+  float left() const { return table->x[row]; }
+  float right() const { return table->x[row] + table->width[row]; }
+  float top() const { return table->y[row]; }
+  float bottom() const { return table->y[row] + table->height[row]; }
+
+  bool is_destroyed() const { return table->destroyed[row] != 0; }
+  void destroy() { table->destroyed[row] = 1; }
+};
+
+//-------------------------------
+// entity types
+//-------------------------------
+struct ball {
+  static void spawn(entity_ref e, float x, float y) {
+    e.x() = x;
+    e.y() = y;
+    e.vx() = constants::ball_speed;
+    e.vy() = constants::ball_speed;
+    e.width() = constants::ball_size;
+    e.height() = constants::ball_size;
+    e.colour() = 0xffffffffu; // the texture's own colours
+  }
+};
+
+struct paddle {
+  static void spawn(entity_ref e, float x, float y) {
+    e.x() = x;
+    e.y() = y;
+    e.width() = constants::paddle_width;
+    e.height() = constants::paddle_height;
+    e.colour() = 0xffffffffu;
+  }
+};
+
+struct brick {
+  static void spawn(entity_ref e, float x, float y) {
+    e.x() = x;
+    e.y() = y;
+    e.width() = constants::brick_width;
+    e.height() = constants::brick_height;
+    e.strength() = constants::brick_strength;
+    e.colour() = brick_colour(constants::brick_strength);
+  }
+};
+
+//-------------------------------
+// entity_manager
+//-------------------------------
+// Types is a type_list of the entity types the manager can hold
+template <typename Types> class basic_entity_manager {
+  struct slot_entry {
+    entity_table *table{nullptr};
+    uint32_t row{0};
+    uint32_t generation{0};
+  };
+
+  // the tables are never moved, so the slots can point at them
+  std::array<entity_table, Types::size> tables;
+  std::vector<slot_entry> slots;
+  std::vector<uint32_t> free_slots;
+  size_t count{0};
+
+public:
+  // the slots point into this manager's tables, so a copy's would too
+  // deleting the copy also means there is no implicit move
+  basic_entity_manager() = default;
+  basic_entity_manager(const basic_entity_manager &) = delete;
+  basic_entity_manager &operator=(const basic_entity_manager &) = delete;
+
+  template <typename T, typename... Args>
+  entity_handle create(Args &&...args) {
+    entity_table &table = get_all<T>();
+    uint32_t s;
+    if (free_slots.empty()) {
+      s = static_cast<uint32_t>(slots.size());
+      slots.emplace_back();
+    } else {
+      s = free_slots.back();
+      free_slots.pop_back();
+    }
+    slots[s].table = &table;
+    slots[s].row = static_cast<uint32_t>(table.size());
+    table.push_back(s);
+    T::spawn(entity_ref(table, table.size() - 1), std::forward<Args>(args)...);
+    ++count;
+    return {s, slots[s].generation};
+  }
+
+  template <typename T> entity_table &get_all() {
+    constexpr size_t index = Types::template index_of<T>();
+    static_assert(index < Types::size,
+                  "this entity type is not one of the manager's types");
+    return tables[index];
+  }
+
+  template <typename T, typename Func> void apply_all(const Func &func) {
+    entity_table &table = get_all<T>();
+    for (size_t row = 0; row < table.size(); ++row) {
+      func(entity_ref(table, row));
+    }
+  }
+
+  bool is_alive(entity_handle h) const {
+    return h.slot < slots.size() && slots[h.slot].table &&
+           slots[h.slot].generation == h.generation;
+  }
+
+  // h must be alive
+  entity_ref get(entity_handle h) {
+    return entity_ref(*slots[h.slot].table, slots[h.slot].row);
+  }
+
+  // remove the destroyed entities, each one replaced by the last row of its
+  // table. The row which moved in is checked next, as it may be destroyed too
+  // memchr skips over the live rows much faster than a loop testing each one
+  void refresh() {
+    for (entity_table &table : tables) {
+      size_t row = 0;
+      while (row < table.size()) {
+        const uint8_t *flags = table.destroyed.data();
+        auto hit = static_cast<const uint8_t *>(
+            std::memchr(flags + row, 1, table.size() - row));
+        if (!hit) {
+          break;
+        }
+        row = hit - flags;
+        slot_entry &gone = slots[table.slot[row]];
+        gone.table = nullptr;
+        ++gone.generation;
+        free_slots.push_back(table.slot[row]);
+        table.swap_and_pop(row);
+        if (row < table.size()) {
+          slots[table.slot[row]].row = static_cast<uint32_t>(row);
+        }
+        --count;
+      }
+    }
+  }
+
+  void clear() {
+    for (entity_table &table : tables) {
+      for (uint32_t s : table.slot) {
+        slots[s].table = nullptr;
+        ++slots[s].generation;
+        free_slots.push_back(s);
+      }
+      table.clear();
+    }
+    count = 0;
+  }
+
+  size_t size() const { return count; }
+};
+
+using entity_manager = basic_entity_manager<type_list<ball, paddle, brick>>;
+
+//-------------------------------
+// systems
+//-------------------------------
+// the arrays are copied into local pointers first. destroyed is an array of
+// bytes, and a store through a byte pointer could change anything as far as
+// the compiler knows, including the vectors' own pointers, which would stop
+// it vectorizing the loops
+
+// the same as ball::update() in 19a_entities.h, for every ball at once
+// the x and y directions are separate loops, as with fewer arrays in a loop
+// the compiler can check they don't overlap and vectorize it
+inline void update_balls(entity_table &t) {
+  size_t n = t.size();
+  float *x = t.x.data();
+  float *y = t.y.data();
+  float *vx = t.vx.data();
+  float *vy = t.vy.data();
+  const float *width = t.width.data();
+  uint8_t *destroyed = t.destroyed.data();
+  for (size_t i = 0; i < n; ++i) {
+    x[i] += vx[i];
+    bool off_side = (x[i] < 0.0f) | (x[i] + width[i] > constants::window_width);
+    vx[i] = off_side ? -vx[i] : vx[i];
+  }
+  for (size_t i = 0; i < n; ++i) {
+    y[i] += vy[i];
+    vy[i] = y[i] < 0.0f ? -vy[i] : vy[i];
+    destroyed[i] |= y[i] > constants::window_height;
+  }
+}
+
+// paddle::update()
+inline void update_paddles(entity_table &t) {
+  size_t n = t.size();
+  float *x = t.x.data();
+  const float *vx = t.vx.data();
+  const float *width = t.width.data();
+  for (size_t i = 0; i < n; ++i) {
+    x[i] = std::clamp(x[i] + vx[i], 0.0f, constants::window_width - width[i]);
+  }
+}
+
+// brick::update()
+inline void update_bricks(entity_table &t) {
+  size_t n = t.size();
+  uint32_t *colour = t.colour.data();
+  const int *strength = t.strength.data();
+  for (size_t i = 0; i < n; ++i) {
+    colour[i] = brick_colour(strength[i]);
+  }
+}
+
+} // namespace soa
+
+#endif // BREAKOUT_SOA_ENTITY_MANAGER_H
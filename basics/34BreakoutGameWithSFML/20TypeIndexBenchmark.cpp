@@ -0,0 +1,88 @@
+/*
+-----------------------------------------------
+ apply_all<brick>: type_info Map vs. Type Index
+-----------------------------------------------
+- "typeid + dynamic_cast" is apply_all() as described in
+  15EntityManagerAndObjectOperations.cpp
+  * Look up typeid(brick).hash_code() in a std::map to find the group
+  * dynamic_cast every entity* in the group to brick*
+- "type index" is entity_manager::apply_all() from 19a_entities.h
+  * The group is an array element at brick's position in the type list
+  * Every entity* is static_cast to brick*
+- Both go through the same groups of the same manager, with a ball created
+  after every ten bricks as in a real game. The function adds up the
+  bricks' strength, so the cost of getting at each brick is most of the
+  work
+- No SFML needed
+
+build: g++ -std=c++20 -O3 -march=native 20TypeIndexBenchmark.cpp
+*/
+
+#include "19a_entities.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <typeinfo>
+
+using namespace std;
+using namespace std::chrono;
+
+using hash_groups = map<size_t, vector<entity *>>;
+
+// the lessons' version
+template <typename T, typename Func>
+void apply_all_typeid(hash_groups &groups, const Func &func) {
+  auto &entity_group = groups[typeid(T).hash_code()];
+  for (auto ptr : entity_group) {
+    func(*dynamic_cast<T *>(ptr));
+  }
+}
+
+template <typename F> double ns_per_brick(int bricks, int calls, F apply) {
+  auto start = steady_clock::now();
+  for (int c = 0; c < calls; ++c) {
+    apply();
+  }
+  duration<double, nano> elapsed = steady_clock::now() - start;
+  return elapsed.count() / calls / bricks;
+}
+
+int main() {
+  cout << setw(10) << "bricks" << setw(18) << "typeid ns/brick" << setw(18)
+       << "index ns/brick" << setw(10) << "speedup" << setw(8) << "same"
+       << "\n";
+
+  for (int bricks : {100, 10000, 1000000}) {
+    entity_manager manager;
+    for (int i = 0; i < bricks; ++i) {
+      manager.create<brick>(static_cast<float>(i % 10) * 43.0f, 0.0f)
+          .set_strength(i % 3 + 1);
+      if (i % 10 == 9) {
+        manager.create<ball>(0.0f, 0.0f);
+      }
+    }
+    hash_groups groups;
+    groups[typeid(ball).hash_code()] = manager.get_all<ball>();
+    groups[typeid(brick).hash_code()] = manager.get_all<brick>();
+
+    // about 100 million bricks visited each way
+    int calls = 100000000 / bricks;
+    long long typeid_total = 0;
+    long long index_total = 0;
+    double typeid_ns = ns_per_brick(bricks, calls, [&] {
+      apply_all_typeid<brick>(
+          groups, [&](brick &b) { typeid_total += b.get_strength(); });
+    });
+    double index_ns = ns_per_brick(bricks, calls, [&] {
+      manager.apply_all<brick>(
+          [&](brick &b) { index_total += b.get_strength(); });
+    });
+
+    cout << setw(10) << bricks << fixed << setprecision(2) << setw(18)
+         << typeid_ns << setw(18) << index_ns << setprecision(1) << setw(10)
+         << typeid_ns / index_ns << defaultfloat << setw(8)
+         << (typeid_total == index_total ? "yes" : "NO") << "\n";
+  }
+}
@@ -0,0 +1,122 @@
+#ifndef BREAKOUT_BRICK_GRID_H
+#define BREAKOUT_BRICK_GRID_H
+
+/*
+--------------------------------
+ Broadphase: A Grid of Bricks
+--------------------------------
+- 15EntityManagerAndObjectOperations.cpp checks every ball against every
+  brick, every frame
+    manager.apply_all<ball>([this](auto& the_ball) {
+      manager.apply_all<brick>([&the_ball](auto& the_brick) {
+        handle_collision(the_ball, the_brick);
+      });
+    });
+  which is balls x bricks overlap tests, nearly all of them for bricks
+  nowhere near the ball
+- brick_grid divides the playing field into square cells and keeps a list
+  of the bricks in each cell
+  * A brick goes in the cell its top left corner is in, so it is in exactly
+    one list and can't be found twice
+  * A brick can stick out of its cell to the right and downwards, by up to
+    its size. So to find the bricks a ball might touch, the ball's bounding
+    box is stretched left and up by the size of the largest brick, and the
+    cells that box covers are searched
+  * Only those candidates get the full overlap test in handle_collision()
+- The grid is kept up to date as the game goes on: when handle_collision()
+  destroys a brick, the brick is taken out of its cell straight away, by
+  swapping it with the last brick in the list and popping it
+  * So the grid never points at a brick which refresh() has deleted
+- Positions outside the field are treated as being in the nearest edge cell
+*/
+
+#include "19a_entities.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+class brick_grid {
+  float cell_size;
+  int columns;
+  int rows;
+  float max_width{0.0f}; // of the bricks inserted so far
+  float max_height{0.0f};
+  std::vector<std::vector<brick *>> cells;
+  std::vector<brick *> candidates; // reused by handle_collisions()
+  size_t count{0};
+
+  int column_of(float x) const {
+    return std::clamp(static_cast<int>(std::floor(x / cell_size)), 0,
+                      columns - 1);
+  }
+  int row_of(float y) const {
+    return std::clamp(static_cast<int>(std::floor(y / cell_size)), 0,
+                      rows - 1);
+  }
+  std::vector<brick *> &cell_of(const brick &b) {
+    return cells[static_cast<size_t>(row_of(b.top())) * columns +
+                 column_of(b.left())];
+  }
+
+public:
+  brick_grid(float width, float height, float cell_size)
+      : cell_size(cell_size),
+        columns(std::max(1, static_cast<int>(std::ceil(width / cell_size)))),
+        rows(std::max(1, static_cast<int>(std::ceil(height / cell_size)))),
+        cells(static_cast<size_t>(columns) * rows) {}
+
+  void insert(brick &b) {
+    cell_of(b).push_back(&b);
+    max_width = std::max(max_width, b.get_size().x);
+    max_height = std::max(max_height, b.get_size().y);
+    ++count;
+  }
+
+  // the brick must not have moved since it was inserted
+  void remove(brick &b) {
+    auto &cell = cell_of(b);
+    auto it = std::find(cell.begin(), cell.end(), &b);
+    if (it != cell.end()) {
+      *it = cell.back();
+      cell.pop_back();
+      --count;
+    }
+  }
+
+  // calls func for every brick whose bounding box could overlap e's
+  template <typename Func>
+  void for_each_candidate(const entity &e, const Func &func) const {
+    int column0 = column_of(e.left() - max_width);
+    int column1 = column_of(e.right());
+    int row0 = row_of(e.top() - max_height);
+    int row1 = row_of(e.bottom());
+    for (int r = row0; r <= row1; ++r) {
+      for (int c = column0; c <= column1; ++c) {
+        for (brick *b : cells[static_cast<size_t>(r) * columns + c]) {
+          func(*b);
+        }
+      }
+    }
+  }
+
+  // handle_collision() with each candidate brick, removing the bricks it
+  // destroys. The candidates are collected first, as removing a brick
+  // changes the list it was found in
+  void handle_collisions(ball &the_ball) {
+    candidates.clear();
+    for_each_candidate(the_ball,
+                       [this](brick &b) { candidates.push_back(&b); });
+    for (brick *b : candidates) {
+      handle_collision(the_ball, *b);
+      if (b->is_destroyed()) {
+        remove(*b);
+      }
+    }
+  }
+
+  size_t size() const { return count; }
+};
+
+#endif // BREAKOUT_BRICK_GRID_H
@@ -0,0 +1,171 @@
+/*
+--------------------------------------
+ Broadphase Stress Test: Many Balls
+--------------------------------------
+- A big level: 200 x 50 = 10,000 bricks at the top of a 8800 x 2200 field,
+  with up to 5,000 balls flying around it in random directions
+- Each frame the balls move and bounce off the walls, collisions are
+  handled and the destroyed bricks are removed with refresh()
+- "every brick" is the nested apply_all<ball>/apply_all<brick> from
+  15EntityManagerAndObjectOperations.cpp, "grid" uses brick_grid
+- Only the collision handling is timed, against a 60 fps frame budget of
+  16.7 ms
+- First a check that the grid finds exactly the ball/brick pairs which are
+  touching, frame after frame, as bricks are destroyed and removed
+- The two versions visit a ball's bricks in a different order, and the last
+  brick a ball hits decides where it bounces, so the games drift apart as
+  they go on. They are timed separately, not compared
+- No SFML needed
+
+build: g++ -std=c++20 -O3 -march=native 21b_broadphase_stress_test.cpp
+*/
+
+#include "21a_brick_grid.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+const int brick_columns = 200;
+const int brick_rows = 50;
+const float gap = 1.0f;
+const float field_width = brick_columns * (constants::brick_width + gap);
+const float field_height = 2200.0f;
+
+// the manager holds the level, and the grid has all its bricks
+void make_level(entity_manager &manager, brick_grid &grid, int balls,
+                unsigned seed) {
+  for (int r = 0; r < brick_rows; ++r) {
+    for (int c = 0; c < brick_columns; ++c) {
+      grid.insert(manager.create<brick>(c * (constants::brick_width + gap),
+                                        r * (constants::brick_height + gap)));
+    }
+  }
+  mt19937 rng(seed);
+  uniform_real_distribution<float> x(0.0f,
+                                     field_width - constants::ball_size);
+  uniform_real_distribution<float> y(0.0f,
+                                     field_height - constants::ball_size);
+  bernoulli_distribution coin;
+  for (int i = 0; i < balls; ++i) {
+    ball &b = manager.create<ball>(x(rng), y(rng));
+    if (coin(rng)) {
+      b.move_left();
+    }
+    if (coin(rng)) {
+      b.move_up();
+    }
+  }
+}
+
+// ball::update() bounces off the edges of the game window, these balls
+// bounce off the edges of the field
+void move_balls(entity_manager &manager) {
+  manager.apply_all<ball>([](ball &b) {
+    vec2 p = b.get_position();
+    vec2 v = b.get_velocity();
+    p.x += v.x;
+    p.y += v.y;
+    if (p.x < 0.0f) {
+      b.move_right();
+    } else if (p.x + constants::ball_size > field_width) {
+      b.move_left();
+    }
+    if (p.y < 0.0f) {
+      b.move_down();
+    } else if (p.y + constants::ball_size > field_height) {
+      b.move_up();
+    }
+    b.set_position(p.x, p.y);
+  });
+}
+
+bool grid_finds_every_pair() {
+  entity_manager manager;
+  brick_grid grid(field_width, field_height, 64.0f);
+  make_level(manager, grid, 2000, 1);
+
+  for (int frame = 0; frame < 200; ++frame) {
+    move_balls(manager);
+    vector<pair<ball *, brick *>> every_brick;
+    vector<pair<ball *, brick *>> from_grid;
+    manager.apply_all<ball>([&](ball &the_ball) {
+      manager.apply_all<brick>([&](brick &the_brick) {
+        if (!the_brick.is_destroyed() && is_interacting(the_ball, the_brick)) {
+          every_brick.emplace_back(&the_ball, &the_brick);
+        }
+      });
+      grid.for_each_candidate(the_ball, [&](brick &the_brick) {
+        if (is_interacting(the_ball, the_brick)) {
+          from_grid.emplace_back(&the_ball, &the_brick);
+        }
+      });
+    });
+    sort(every_brick.begin(), every_brick.end());
+    sort(from_grid.begin(), from_grid.end());
+    if (every_brick != from_grid) {
+      return false;
+    }
+
+    manager.apply_all<ball>([&](ball &b) { grid.handle_collisions(b); });
+    manager.refresh();
+    if (grid.size() != manager.get_all<brick>().size()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// the average time per frame for the collisions
+template <typename Collide>
+double collision_ms(int balls, int frames, Collide collide) {
+  entity_manager manager;
+  brick_grid grid(field_width, field_height, 64.0f);
+  make_level(manager, grid, balls, 2);
+  duration<double, milli> total{0};
+  for (int frame = 0; frame < frames; ++frame) {
+    move_balls(manager);
+    auto start = steady_clock::now();
+    collide(manager, grid);
+    total += steady_clock::now() - start;
+    manager.refresh();
+  }
+  return total.count() / frames;
+}
+
+int main() {
+  cout << "grid finds exactly the touching pairs: "
+       << (grid_finds_every_pair() ? "yes" : "NO") << "\n\n";
+
+  auto every_brick = [](entity_manager &manager, brick_grid &) {
+    manager.apply_all<ball>([&manager](ball &the_ball) {
+      manager.apply_all<brick>([&the_ball](brick &the_brick) {
+        handle_collision(the_ball, the_brick);
+      });
+    });
+  };
+  auto grid = [](entity_manager &manager, brick_grid &grid) {
+    manager.apply_all<ball>([&grid](ball &b) { grid.handle_collisions(b); });
+  };
+
+  cout << brick_columns * brick_rows << " bricks, collision ms/frame\n";
+  cout << setw(8) << "balls" << setw(14) << "every brick" << setw(10)
+       << "grid" << setw(10) << "speedup" << "\n";
+  for (int balls : {10, 100, 1000, 5000}) {
+    // the nested loops are slow enough with many balls that a few frames
+    // are plenty
+    int slow_frames = max(5, 20000 / balls);
+    double slow = collision_ms(balls, slow_frames, every_brick);
+    double fast = collision_ms(balls, 300, grid);
+    cout << setw(8) << balls << fixed << setprecision(3) << setw(14) << slow
+         << setw(10) << fast << setprecision(0) << setw(10) << slow / fast
+         << defaultfloat << "\n";
+  }
+}
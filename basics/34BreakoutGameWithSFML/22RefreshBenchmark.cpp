@@ -0,0 +1,212 @@
+/*
+--------------------------------------------
+ refresh(): remove_if + Heap vs. Swap + Pool
+--------------------------------------------
+- "lessons" is the entity manager from 15EntityManagerAndObjectOperations.cpp
+  (with the type index groups from 19a_entities.h)
+  * refresh() erases the destroyed entities with remove_if, from every group
+    and then from all_entities
+  * Every entity is created with make_unique and deleted by its unique_ptr
+- "pooled" is entity_manager from 19a_entities.h
+  * refresh() swap-and-pops each destroyed entity out of all_entities and
+    its group, in one pass
+  * The entity's storage goes back to a pool and is reused by create()
+- The frames are those of 19c_entity_manager_benchmark.cpp: 100,000
+  entities, update() all of them, refresh() to remove the balls which fell
+  off the bottom and create new balls to replace them
+- Calls to operator new are counted, to see how often each manager goes to
+  the heap once the game is running
+- Both managers get the same balls, so they should end up in the same state
+- No SFML needed
+
+build: g++ -std=c++20 -O3 -march=native 22RefreshBenchmark.cpp
+*/
+
+#include "19a_entities.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <unordered_set>
+
+using namespace std;
+using namespace std::chrono;
+
+// every call to operator new, from anywhere
+static long long allocations = 0;
+
+void *operator new(size_t size) {
+  ++allocations;
+  if (void *p = malloc(size ? size : 1)) {
+    return p;
+  }
+  throw bad_alloc();
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+// the manager from the lessons
+class lessons_manager {
+  using types = type_list<ball, paddle, brick>;
+  vector<unique_ptr<entity>> all_entities;
+  array<vector<entity *>, types::size> grouped_entities;
+
+public:
+  template <typename T, typename... Args> T &create(Args &&...args) {
+    auto ptr = make_unique<T>(std::forward<Args>(args)...);
+    auto alias = ptr.get();
+    all_entities.emplace_back(std::move(ptr));
+    grouped_entities[types::index_of<T>()].emplace_back(alias);
+    return *alias;
+  }
+
+  void refresh() {
+    for (auto &alias_vector : grouped_entities) {
+      alias_vector.erase(
+          remove_if(alias_vector.begin(), alias_vector.end(),
+                    [](auto p) { return p->is_destroyed(); }),
+          alias_vector.end());
+    }
+    all_entities.erase(
+        remove_if(all_entities.begin(), all_entities.end(),
+                  [](const auto &p) { return p->is_destroyed(); }),
+        all_entities.end());
+  }
+
+  template <typename T> auto &get_all() {
+    return grouped_entities[types::index_of<T>()];
+  }
+
+  template <typename T, typename Func> void apply_all(const Func &func) {
+    for (auto ptr : get_all<T>()) {
+      func(*static_cast<T *>(ptr));
+    }
+  }
+
+  void update() {
+    for (auto &e : all_entities) {
+      e->update();
+    }
+  }
+
+  size_t size() const { return all_entities.size(); }
+};
+
+const int balls = 50000;
+const int bricks = 49999;
+const int frames = 500;
+
+struct spawner {
+  mt19937 rng{12345};
+  uniform_real_distribution<float> x{0.0f, constants::window_width -
+                                               constants::ball_size};
+  uniform_real_distribution<float> y{0.0f, constants::window_height};
+  bernoulli_distribution coin;
+};
+
+struct result {
+  double ms_per_frame;
+  double allocations_per_frame;
+  double checksum;
+  long long balls_replaced;
+  bool consistent{true};
+};
+
+// every entity is in exactly one group, and no group holds a destroyed one
+template <typename Manager> bool groups_consistent(Manager &manager) {
+  unordered_set<entity *> seen;
+  bool ok = true;
+  auto check = [&](entity *e) {
+    ok = ok && !e->is_destroyed() && seen.insert(e).second;
+  };
+  for (entity *e : manager.template get_all<ball>()) {
+    check(e);
+  }
+  for (entity *e : manager.template get_all<paddle>()) {
+    check(e);
+  }
+  for (entity *e : manager.template get_all<brick>()) {
+    check(e);
+  }
+  return ok && seen.size() == manager.size();
+}
+
+template <typename Manager> result run() {
+  Manager manager;
+  spawner s;
+  auto add_balls = [&](int n) {
+    for (int i = 0; i < n; ++i) {
+      float x = s.x(s.rng);
+      float y = s.y(s.rng);
+      ball &b = manager.template create<ball>(x, y);
+      if (s.coin(s.rng)) {
+        b.move_left();
+      }
+      if (s.coin(s.rng)) {
+        b.move_up();
+      }
+    }
+  };
+  add_balls(balls);
+  for (int i = 0; i < bricks; ++i) {
+    float x = s.x(s.rng);
+    float y = s.y(s.rng);
+    manager.template create<brick>(x, y);
+  }
+  manager.template create<paddle>(constants::window_width / 2.0f,
+                                  constants::window_height - 50.0f);
+
+  result r;
+  r.balls_replaced = 0;
+  long long allocations_before = allocations;
+  auto start = steady_clock::now();
+  for (int f = 0; f < frames; ++f) {
+    manager.update();
+    manager.refresh();
+    int missing =
+        balls - static_cast<int>(manager.template get_all<ball>().size());
+    add_balls(missing);
+    r.balls_replaced += missing;
+  }
+  duration<double, milli> elapsed = steady_clock::now() - start;
+  r.ms_per_frame = elapsed.count() / frames;
+  r.allocations_per_frame =
+      static_cast<double>(allocations - allocations_before) / frames;
+
+  r.consistent = groups_consistent(manager);
+  r.checksum = 0.0;
+  manager.template apply_all<ball>([&](ball &b) {
+    r.checksum += b.get_position().x + b.get_position().y;
+  });
+  return r;
+}
+
+int main() {
+  result lessons = run<lessons_manager>();
+  result pooled = run<entity_manager>();
+
+  // the balls are in a different order, so allow for rounding in the sums
+  bool same = lessons.balls_replaced == pooled.balls_replaced &&
+              abs(lessons.checksum - pooled.checksum) <=
+                  1e-6 * abs(lessons.checksum);
+
+  cout << balls + bricks + 1 << " entities, " << frames << " frames, "
+       << lessons.balls_replaced / frames << " balls replaced per frame\n";
+  cout << setw(10) << "" << setw(12) << "ms/frame" << setw(16)
+       << "allocs/frame" << setw(14) << "consistent" << "\n";
+  auto row = [](const char *name, const result &r) {
+    cout << setw(10) << name << fixed << setprecision(3) << setw(12)
+         << r.ms_per_frame << setprecision(1) << setw(16)
+         << r.allocations_per_frame << defaultfloat << setw(14)
+         << (r.consistent ? "yes" : "NO") << "\n";
+  };
+  row("lessons", lessons);
+  row("pooled", pooled);
+  cout << "speedup " << fixed << setprecision(1)
+       << lessons.ms_per_frame / pooled.ms_per_frame << defaultfloat
+       << ", same final state: " << (same ? "yes" : "NO") << "\n";
+}
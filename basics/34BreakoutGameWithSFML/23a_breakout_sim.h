@@ -0,0 +1,217 @@
+#ifndef BREAKOUT_SIM_H
+#define BREAKOUT_SIM_H
+
+/*
+---------------------------------
+ Breakout Simulation, Headless
+---------------------------------
+- In the lessons, game_manager::run() reads the keyboard, updates the
+  entities and draws them, once per frame, with the frame rate limited to
+  60 fps. So the game can only run as fast as the window, and only with a
+  window
+- breakout_sim is the game without the window: the entities from
+  19a_entities.h, the collisions, the lives and the game state
+  * The ball is only tested against the bricks near it, found with the
+    brick_grid from 21a_brick_grid.h, not against every brick as in the
+    lessons. Even with the lessons' 40 bricks that makes a tick a little
+    faster, and a bigger wall costs no more per tick
+  * step() moves the game on by one tick, which is one frame of the lessons
+    at 60 fps. The speeds in constants are per tick
+  * The player's input for the tick is passed to step(), instead of being
+    read from the keyboard
+  * There is nothing random in the game, so the same inputs always give the
+    same game, which can be checked with hash()
+  * Many breakout_sims can run at once in different threads, as they don't
+    share anything
+- fixed_timestep is for a game loop with a window
+  * The loop tells it how much time has passed since the last frame, and it
+    calls step() once for every whole tick in that time
+  * Drawing then happens as often as the window allows, and the game runs
+    at the same speed whatever the frame rate is
+    fixed_timestep timer(breakout_sim::tick);
+    sf::Clock clock;
+    while (window.isOpen()) {
+      timer.advance(clock.restart().asMicroseconds() * 1us,
+                    [&] { sim.step(read_keyboard()); });
+      draw(window, sim);
+    }
+*/
+
+#include "19a_entities.h"
+#include "21a_brick_grid.h"
+
+#include <bit>
+#include <chrono>
+#include <cstdint>
+
+enum class paddle_input : uint8_t { none, left, right };
+
+class breakout_sim {
+public:
+  enum class game_state { running, game_over, player_wins };
+
+  static constexpr std::chrono::nanoseconds tick{1'000'000'000 / 60};
+  static constexpr int player_lives{3};
+
+private:
+  // a cell holds about one brick
+  static constexpr float grid_cell{48.0f};
+
+  entity_manager manager;
+  brick_grid bricks{constants::window_width, constants::window_height,
+                    grid_cell};
+  game_state state{game_state::running};
+  int lives{player_lives};
+  uint64_t ticks{0};
+
+  void new_ball() {
+    manager.create<ball>(constants::window_width / 2.0f,
+                         constants::window_height / 2.0f);
+  }
+
+public:
+  breakout_sim() { reset(); }
+
+  // the start of a game: a ball, the paddle and the wall of bricks
+  void reset() {
+    manager.clear();
+    bricks = brick_grid(constants::window_width, constants::window_height,
+                        grid_cell);
+    state = game_state::running;
+    lives = player_lives;
+    ticks = 0;
+    for (int i = 0; i < constants::brick_columns; ++i) {
+      for (int j = 0; j < constants::brick_rows; ++j) {
+        float x = constants::brick_offset + (i + 1) * constants::brick_width;
+        float y = (j + 2) * constants::brick_height;
+        bricks.insert(manager.create<brick>(x, y));
+      }
+    }
+    new_ball();
+    manager.create<paddle>(
+        (constants::window_width - constants::paddle_width) / 2.0f,
+        constants::window_height - constants::paddle_height);
+  }
+
+  // one tick of the game loop; does nothing once the game has finished
+  void step(paddle_input input) {
+    if (state != game_state::running) {
+      return;
+    }
+    ++ticks;
+    manager.apply_all<paddle>([input](paddle &p) {
+      if (input == paddle_input::left) {
+        p.move_left();
+      } else if (input == paddle_input::right) {
+        p.move_right();
+      } else {
+        p.stop();
+      }
+    });
+
+    manager.update();
+    manager.apply_all<ball>([this](ball &the_ball) {
+      manager.apply_all<paddle>(
+          [&the_ball](paddle &p) { handle_collision(the_ball, p); });
+      bricks.handle_collisions(the_ball);
+    });
+    manager.refresh();
+
+    if (manager.get_all<brick>().empty()) {
+      state = game_state::player_wins;
+    } else if (manager.get_all<ball>().empty()) {
+      if (--lives == 0) {
+        state = game_state::game_over;
+      } else {
+        new_ball();
+      }
+    }
+  }
+
+  game_state get_state() const noexcept { return state; }
+  bool is_running() const noexcept { return state == game_state::running; }
+  int get_lives() const noexcept { return lives; }
+  uint64_t get_ticks() const noexcept { return ticks; }
+  size_t bricks_left() { return manager.get_all<brick>().size(); }
+
+  // the first ball and the paddle, for a player deciding what to do
+  const ball *get_ball() {
+    auto &balls = manager.get_all<ball>();
+    return balls.empty() ? nullptr : static_cast<const ball *>(balls[0]);
+  }
+  const paddle &get_paddle() {
+    return *static_cast<const paddle *>(manager.get_all<paddle>()[0]);
+  }
+
+  // FNV-1a over everything that makes up the state of the game. Two games
+  // with the same hash are, to all intents, in the same state
+  uint64_t hash() {
+    uint64_t h = 0xcbf29ce484222325ull;
+    auto add = [&h](uint64_t value) {
+      for (int i = 0; i < 8; ++i) {
+        h = (h ^ (value & 0xff)) * 0x100000001b3ull;
+        value >>= 8;
+      }
+    };
+    auto add_position = [&add](const entity &e) {
+      add(std::bit_cast<uint32_t>(e.get_position().x));
+      add(std::bit_cast<uint32_t>(e.get_position().y));
+    };
+    add(ticks);
+    add(static_cast<uint64_t>(state));
+    add(static_cast<uint64_t>(lives));
+    manager.apply_all<ball>([&](ball &b) {
+      add_position(b);
+      add(std::bit_cast<uint32_t>(b.get_velocity().x));
+      add(std::bit_cast<uint32_t>(b.get_velocity().y));
+    });
+    manager.apply_all<paddle>([&](paddle &p) { add_position(p); });
+    manager.apply_all<brick>([&](brick &b) {
+      add_position(b);
+      add(static_cast<uint64_t>(b.get_strength()));
+    });
+    return h;
+  }
+};
+
+//-------------------------------
+// fixed_timestep
+//-------------------------------
+// turns the time between frames into a whole number of ticks. The time left
+// over is carried on to the next frame
+// If the game falls a long way behind, for instance while the window is
+// being dragged, it doesn't try to catch up more than max_steps ticks in one
+// frame, as that would take even longer
+class fixed_timestep {
+  std::chrono::nanoseconds step;
+  std::chrono::nanoseconds lag{0};
+  int max_steps;
+
+public:
+  explicit fixed_timestep(std::chrono::nanoseconds step, int max_steps = 5)
+      : step(step), max_steps(max_steps) {}
+
+  // calls tick() for each whole step, and returns how many times it did
+  template <typename Tick>
+  int advance(std::chrono::nanoseconds elapsed, Tick tick) {
+    lag += elapsed;
+    int steps = 0;
+    while (lag >= step && steps < max_steps) {
+      tick();
+      lag -= step;
+      ++steps;
+    }
+    if (lag >= step) {
+      lag = lag % step; // give up on the ticks it couldn't manage
+    }
+    return steps;
+  }
+
+  // how far the game is into the next tick, from 0 to 1, for drawing the
+  // entities between where they are and where they will be
+  float alpha() const noexcept {
+    return static_cast<float>(lag.count()) / static_cast<float>(step.count());
+  }
+};
+
+#endif // BREAKOUT_SIM_H
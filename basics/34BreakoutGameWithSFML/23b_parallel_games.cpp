@@ -0,0 +1,179 @@
+/*
+---------------------------------------
+ Thousands of Headless Breakout Games
+---------------------------------------
+- Each game is played by a computer player which follows the ball, and
+  which now and then does something random instead. The randomness comes
+  from a generator seeded with the game's number, so game n is always
+  played the same way
+- A game ends when it is lost or won, or after max_ticks ticks
+- The games are shared out between threads, which take the next unplayed
+  game until there are none left
+- Checks
+  * Playing all the games again, with a different number of threads, gives
+    exactly the same final state for every game
+  * Replaying a game from a record of its inputs, with no player, gives the
+    same final state. This is what a replay file would hold
+- The steps/second is the total number of ticks played by all the games
+  divided by the time taken. The lessons' game is limited to 60 steps a
+  second
+- No SFML needed
+
+build: g++ -std=c++20 -O3 -march=native 23b_parallel_games.cpp
+*/
+
+#include "23a_breakout_sim.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+const int games = 2000;
+const uint64_t max_ticks = 20000;
+
+struct game_result {
+  uint64_t hash;
+  uint64_t ticks;
+  breakout_sim::game_state state;
+};
+
+// heads for the ball, but 1 time in 64 presses something at random
+class computer_player {
+  mt19937 rng;
+  uniform_int_distribution<int> mistake{0, 63};
+  uniform_int_distribution<int> any_input{0, 2};
+
+public:
+  explicit computer_player(unsigned seed) : rng(seed) {}
+
+  paddle_input choose(breakout_sim &sim) {
+    if (mistake(rng) == 0) {
+      return static_cast<paddle_input>(any_input(rng));
+    }
+    const ball *b = sim.get_ball();
+    if (!b) {
+      return paddle_input::none;
+    }
+    float to_ball = b->x() - sim.get_paddle().x();
+    if (to_ball < -constants::paddle_width / 4.0f) {
+      return paddle_input::left;
+    }
+    if (to_ball > constants::paddle_width / 4.0f) {
+      return paddle_input::right;
+    }
+    return paddle_input::none;
+  }
+};
+
+// inputs is filled with what the player pressed, if it is given
+game_result play(int game, vector<paddle_input> *inputs = nullptr) {
+  breakout_sim sim;
+  computer_player player(static_cast<unsigned>(game));
+  while (sim.is_running() && sim.get_ticks() < max_ticks) {
+    paddle_input input = player.choose(sim);
+    if (inputs) {
+      inputs->push_back(input);
+    }
+    sim.step(input);
+  }
+  return {sim.hash(), sim.get_ticks(), sim.get_state()};
+}
+
+game_result replay(const vector<paddle_input> &inputs) {
+  breakout_sim sim;
+  for (paddle_input input : inputs) {
+    sim.step(input);
+  }
+  return {sim.hash(), sim.get_ticks(), sim.get_state()};
+}
+
+vector<game_result> play_all(unsigned threads) {
+  vector<game_result> results(games);
+  atomic<int> next_game{0};
+  auto work = [&] {
+    for (int g = next_game++; g < games; g = next_game++) {
+      results[g] = play(g);
+    }
+  };
+  vector<jthread> workers;
+  for (unsigned t = 1; t < threads; ++t) {
+    workers.emplace_back(work);
+  }
+  work(); // this thread plays too
+  return results; // the jthreads have finished by the time this returns
+}
+
+bool same_games(const vector<game_result> &a, const vector<game_result> &b) {
+  return equal(a.begin(), a.end(), b.begin(), b.end(),
+               [](const game_result &x, const game_result &y) {
+                 return x.hash == y.hash && x.ticks == y.ticks;
+               });
+}
+
+int main() {
+  unsigned cores = max(thread::hardware_concurrency(), 1u);
+  cout << games << " games of up to " << max_ticks << " ticks, " << cores
+       << " hardware threads\n\n";
+
+  vector<unsigned> thread_counts{1};
+  for (unsigned t : {2u, 4u, cores}) {
+    if (t <= cores && t != thread_counts.back()) {
+      thread_counts.push_back(t);
+    }
+  }
+  thread_counts.push_back(cores * 2); // more threads than cores
+
+  vector<game_result> first;
+  bool all_same = true;
+  cout << setw(10) << "threads" << setw(10) << "seconds" << setw(16)
+       << "steps/second" << setw(10) << "same" << "\n";
+  for (unsigned threads : thread_counts) {
+    auto start = steady_clock::now();
+    vector<game_result> results = play_all(threads);
+    duration<double> elapsed = steady_clock::now() - start;
+
+    uint64_t steps = 0;
+    for (auto &r : results) {
+      steps += r.ticks;
+    }
+    if (first.empty()) {
+      first = results;
+    }
+    bool same = same_games(first, results);
+    all_same = all_same && same;
+    cout << setw(10) << threads << fixed << setprecision(2) << setw(10)
+         << elapsed.count() << setprecision(0) << setw(16)
+         << steps / elapsed.count() << defaultfloat << setw(10)
+         << (same ? "yes" : "NO") << "\n";
+  }
+
+  int won = 0;
+  int lost = 0;
+  for (auto &r : first) {
+    won += r.state == breakout_sim::game_state::player_wins;
+    lost += r.state == breakout_sim::game_state::game_over;
+  }
+  cout << "\nwon " << won << ", lost " << lost << ", unfinished "
+       << games - won - lost << "\n";
+
+  bool replays_match = true;
+  for (int g = 0; g < 20; ++g) {
+    vector<paddle_input> inputs;
+    game_result played = play(g, &inputs);
+    game_result replayed = replay(inputs);
+    replays_match = replays_match && played.hash == replayed.hash &&
+                    played.hash == first[g].hash;
+  }
+  cout << "same results with any number of threads: "
+       << (all_same ? "yes" : "NO") << "\n";
+  cout << "replays match the games: " << (replays_match ? "yes" : "NO")
+       << "\n";
+}
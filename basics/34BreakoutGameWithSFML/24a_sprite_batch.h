@@ -0,0 +1,178 @@
+#ifndef BREAKOUT_SPRITE_BATCH_H
+#define BREAKOUT_SPRITE_BATCH_H
+
+/*
+-----------------------
+ Batched Sprite Drawing
+-----------------------
+- In the lessons every entity has its own sf::Sprite and draws it itself
+    void draw(sf::RenderWindow& window) override { window.draw(sprite); }
+  so drawing 40 bricks is 40 draw calls, each with the brick's transform,
+  a texture bind check and a handful of OpenGL calls for just 4 vertices
+- All the bricks use the same texture, as do the balls. So the whole frame
+  can be drawn with one draw call per texture, if the quads of all the
+  sprites which use a texture are put in one vertex array
+- sprite_batch builds those vertex arrays
+  * A texture is registered once, with its size in pixels, and gets an id
+  * Each frame: clear(), then add() each sprite with its texture id,
+    position, size and colour, or add_all() a whole soa::entity_table
+  * add_all() is a loop down the table's x, y, width, height and colour
+    arrays, writing vertices, with nothing virtual and no transforms
+  * A sprite is two triangles, six vertices, already in window
+    coordinates, so the draw calls need no transform
+  * clear() keeps the arrays' memory, so a running game doesn't allocate
+- vertex has the same layout as sf::Vertex (position, RGBA colour, texture
+  coordinates in pixels)
+  * With BREAKOUT_USE_SFML defined, draw() hands the arrays to an
+    sf::RenderTarget as they are, one draw call per texture
+  * Without it, there is no SFML code at all, and the arrays can be looked
+    at or timed
+- Colours are the 0xAARRGGBB values the headless entities use
+*/
+
+#include "19b_soa_entity_manager.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef BREAKOUT_USE_SFML
+#include <SFML/Graphics.hpp>
+#endif
+
+struct vertex {
+  float x, y;         // position
+  uint8_t r, g, b, a; // colour
+  float u, v;         // texture coordinates, in pixels
+
+  // left uninitialized, so growing a vertex array doesn't fill it with
+  // zeros which are about to be overwritten
+  vertex() {}
+  vertex(float x, float y, uint8_t r, uint8_t g, uint8_t b, uint8_t a,
+         float u, float v)
+      : x(x), y(y), r(r), g(g), b(b), a(a), u(u), v(v) {}
+};
+static_assert(sizeof(vertex) == 20, "vertex must match sf::Vertex");
+
+class sprite_batch {
+public:
+  using texture_id = size_t;
+
+private:
+  struct layer {
+    vec2 texture_size;
+    std::vector<vertex> vertices;
+#ifdef BREAKOUT_USE_SFML
+    const sf::Texture *texture{nullptr};
+#endif
+  };
+  std::vector<layer> layers; // one per texture
+
+  // the two triangles of the quad from (x0, y0) to (x1, y1)
+  static vertex *write_quad(vertex *out, float x0, float y0, float x1,
+                            float y1, uint32_t argb, vec2 t) {
+    uint8_t r = static_cast<uint8_t>(argb >> 16);
+    uint8_t g = static_cast<uint8_t>(argb >> 8);
+    uint8_t b = static_cast<uint8_t>(argb);
+    uint8_t a = static_cast<uint8_t>(argb >> 24);
+    vertex top_left{x0, y0, r, g, b, a, 0.0f, 0.0f};
+    vertex top_right{x1, y0, r, g, b, a, t.x, 0.0f};
+    vertex bottom_left{x0, y1, r, g, b, a, 0.0f, t.y};
+    vertex bottom_right{x1, y1, r, g, b, a, t.x, t.y};
+    out[0] = top_left;
+    out[1] = top_right;
+    out[2] = bottom_left;
+    out[3] = bottom_left;
+    out[4] = top_right;
+    out[5] = bottom_right;
+    return out + 6;
+  }
+
+public:
+  static constexpr size_t vertices_per_sprite = 6;
+
+  texture_id add_texture(vec2 size) {
+    layers.push_back({size, {}});
+    return layers.size() - 1;
+  }
+
+#ifdef BREAKOUT_USE_SFML
+  texture_id add_texture(const sf::Texture &texture) {
+    texture_id id = add_texture({static_cast<float>(texture.getSize().x),
+                                 static_cast<float>(texture.getSize().y)});
+    layers[id].texture = &texture;
+    return id;
+  }
+#endif
+
+  // start a new frame
+  void clear() {
+    for (auto &l : layers) {
+      l.vertices.clear();
+    }
+  }
+
+  void add(texture_id texture, vec2 position, vec2 size, uint32_t colour) {
+    layer &l = layers[texture];
+    size_t n = l.vertices.size();
+    l.vertices.resize(n + vertices_per_sprite);
+    write_quad(l.vertices.data() + n, position.x, position.y,
+               position.x + size.x, position.y + size.y, colour,
+               l.texture_size);
+  }
+
+  void add(texture_id texture, const entity &e, uint32_t colour) {
+    add(texture, e.get_position(), e.get_size(), colour);
+  }
+
+  // every entity in the table
+  void add_all(texture_id texture, const soa::entity_table &table) {
+    layer &l = layers[texture];
+    size_t rows = table.size();
+    size_t n = l.vertices.size();
+    l.vertices.resize(n + rows * vertices_per_sprite);
+    vertex *out = l.vertices.data() + n;
+    const float *x = table.x.data();
+    const float *y = table.y.data();
+    const float *width = table.width.data();
+    const float *height = table.height.data();
+    const uint32_t *colour = table.colour.data();
+    vec2 t = l.texture_size;
+    for (size_t i = 0; i < rows; ++i) {
+      out = write_quad(out, x[i], y[i], x[i] + width[i], y[i] + height[i],
+                       colour[i], t);
+    }
+  }
+
+  const std::vector<vertex> &vertices(texture_id texture) const {
+    return layers[texture].vertices;
+  }
+
+  size_t texture_count() const { return layers.size(); }
+
+  // the draw calls a frame takes: one for each texture with any sprites
+  size_t draw_calls() const {
+    size_t calls = 0;
+    for (auto &l : layers) {
+      calls += !l.vertices.empty();
+    }
+    return calls;
+  }
+
+#ifdef BREAKOUT_USE_SFML
+  void draw(sf::RenderTarget &target) const {
+    static_assert(sizeof(sf::Vertex) == sizeof(vertex));
+    for (auto &l : layers) {
+      if (l.vertices.empty()) {
+        continue;
+      }
+      sf::RenderStates states;
+      states.texture = l.texture;
+      target.draw(reinterpret_cast<const sf::Vertex *>(l.vertices.data()),
+                  l.vertices.size(), sf::Triangles, states);
+    }
+  }
+#endif
+};
+
+#endif // BREAKOUT_SPRITE_BATCH_H
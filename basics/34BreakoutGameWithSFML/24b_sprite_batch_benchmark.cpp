@@ -0,0 +1,341 @@
+/*
+-------------------------------------------
+ Drawing: A Sprite Each vs. Sprite Batches
+-------------------------------------------
+- There is no SFML here, so the draw pass of each version is done down to
+  the point where SFML would call OpenGL, and the vertices which would be
+  handed to OpenGL are copied into a buffer standing in for it
+- "per entity" is what window.draw(sprite) does, as in 4Sprites.cpp and
+  10Bricks.cpp, once per entity
+  * headless_sprite is an sf::Sprite: four vertices in its own coordinates,
+    and a transform, worked out from the position when it has changed
+  * headless_window::draw() is sf::RenderTarget::draw(): it combines the
+    transform with the window's, transforms the four vertices itself (SFML
+    does this for very small arrays, rather than changing the OpenGL
+    matrix) and makes a draw call for them
+- "batch, objects" uses sprite_batch from 24a_sprite_batch.h, adding the
+  entities of the pointer-based entity_manager one at a time
+- "batch, arrays" uses sprite_batch::add_all() on the tables of the
+  data-oriented entity manager, the entity position arrays
+- A batch is handed over with one draw call per texture
+- The time is the CPU time of the draw pass. What this can't show is the
+  time saved in the graphics driver and on the GPU: each OpenGL draw call
+  costs microseconds there, which is the real reason for batching. So the
+  number of draw calls is shown as well
+- Each version's quads are checked against the others'
+- No SFML needed
+
+build: g++ -std=c++20 -O3 -march=native 24b_sprite_batch_benchmark.cpp
+*/
+
+#include "24a_sprite_batch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// an affine transform, as a 3x3 matrix with the bottom row 0 0 1
+struct affine {
+  float a{1}, b{0}, tx{0};
+  float c{0}, d{1}, ty{0};
+
+  affine operator*(const affine &t) const {
+    return {a * t.a + b * t.c, a * t.b + b * t.d, a * t.tx + b * t.ty + tx,
+            c * t.a + d * t.c, c * t.b + d * t.d, c * t.tx + d * t.ty + ty};
+  }
+  vertex apply(vertex v) const {
+    float x = a * v.x + b * v.y + tx;
+    float y = c * v.x + d * v.y + ty;
+    v.x = x;
+    v.y = y;
+    return v;
+  }
+};
+
+struct texture {
+  vec2 size;
+};
+
+// sf::Sprite, without the texture rectangle, origin and scale
+class headless_sprite {
+  const texture *tex;
+  vertex vertices[4]; // a triangle strip, as in sf::Sprite
+  vec2 position;
+  float rotation{0.0f};
+  mutable affine cached;
+  mutable bool transform_changed{true};
+
+public:
+  explicit headless_sprite(const texture &t) : tex(&t) {
+    float w = t.size.x;
+    float h = t.size.y;
+    vertices[0] = {0, 0, 255, 255, 255, 255, 0, 0};
+    vertices[1] = {0, h, 255, 255, 255, 255, 0, h};
+    vertices[2] = {w, 0, 255, 255, 255, 255, w, 0};
+    vertices[3] = {w, h, 255, 255, 255, 255, w, h};
+  }
+
+  void set_position(vec2 p) {
+    position = p;
+    transform_changed = true;
+  }
+  void set_colour(uint32_t argb) {
+    for (vertex &v : vertices) {
+      v.r = static_cast<uint8_t>(argb >> 16);
+      v.g = static_cast<uint8_t>(argb >> 8);
+      v.b = static_cast<uint8_t>(argb);
+      v.a = static_cast<uint8_t>(argb >> 24);
+    }
+  }
+
+  // as sf::Transformable::getTransform()
+  const affine &get_transform() const {
+    if (transform_changed) {
+      float angle = -rotation * 3.141592654f / 180.0f;
+      float cosine = std::cos(angle);
+      float sine = std::sin(angle);
+      cached = {cosine, sine, position.x, -sine, cosine, position.y};
+      transform_changed = false;
+    }
+    return cached;
+  }
+
+  const vertex *get_vertices() const { return vertices; }
+  const texture *get_texture() const { return tex; }
+};
+
+// sf::RenderWindow, with OpenGL replaced by a buffer of vertices
+class headless_window {
+  affine view; // the window's own transform
+  const texture *bound{nullptr};
+
+public:
+  vector<vertex> submitted; // what OpenGL would have been given
+  size_t draw_calls{0};
+  size_t texture_binds{0};
+
+  void begin_frame() {
+    submitted.clear();
+    draw_calls = 0;
+    texture_binds = 0;
+    bound = nullptr;
+  }
+
+  void bind(const texture *t) {
+    if (t != bound) {
+      bound = t;
+      ++texture_binds;
+    }
+  }
+
+  void draw(const headless_sprite &sprite) {
+    affine t = view * sprite.get_transform();
+    bind(sprite.get_texture());
+    vertex cache[4];
+    for (int i = 0; i < 4; ++i) {
+      cache[i] = t.apply(sprite.get_vertices()[i]);
+    }
+    size_t n = submitted.size();
+    submitted.resize(n + 4);
+    memcpy(submitted.data() + n, cache, sizeof cache);
+    ++draw_calls;
+  }
+
+  void draw(const vector<vertex> &vertices, const texture *t) {
+    bind(t);
+    size_t n = submitted.size();
+    submitted.resize(n + vertices.size());
+    memcpy(submitted.data() + n, vertices.data(),
+           vertices.size() * sizeof(vertex));
+    ++draw_calls;
+  }
+};
+
+// the lessons' entities each own a sprite, and draw it themselves
+class drawn_ball : public ball {
+  headless_sprite sprite;
+
+public:
+  drawn_ball(float x, float y, const texture &t) : ball(x, y), sprite(t) {}
+  void draw(headless_window &window) {
+    sprite.set_position(position);
+    window.draw(sprite);
+  }
+};
+
+class drawn_paddle : public paddle {
+  headless_sprite sprite;
+
+public:
+  drawn_paddle(float x, float y, const texture &t)
+      : paddle(x, y), sprite(t) {}
+  void draw(headless_window &window) {
+    sprite.set_position(position);
+    window.draw(sprite);
+  }
+};
+
+class drawn_brick : public brick {
+  headless_sprite sprite;
+
+public:
+  drawn_brick(float x, float y, const texture &t) : brick(x, y), sprite(t) {
+    sprite.set_position(position); // bricks don't move
+  }
+  void draw(headless_window &window) {
+    sprite.set_colour(get_colour());
+    window.draw(sprite);
+  }
+};
+
+using drawn_manager =
+    basic_entity_manager<type_list<drawn_ball, drawn_paddle, drawn_brick>>;
+
+const texture ball_texture{{constants::ball_size, constants::ball_size}};
+const texture paddle_texture{
+    {constants::paddle_width, constants::paddle_height}};
+const texture brick_texture{{constants::brick_width, constants::brick_height}};
+const int balls = 10;
+
+// where the i'th brick goes, in rows of 100 with a few different strengths
+vec2 brick_position(int i) {
+  return {static_cast<float>(i % 100) * constants::brick_width,
+          static_cast<float>(i / 100) * constants::brick_height};
+}
+int brick_strength(int i) { return i % 3 + 1; }
+vec2 ball_position(int i) { return {i * 40.0f, 300.0f}; }
+const vec2 paddle_position{230.0f, 430.0f};
+
+// the quads a window was given, as corners and colour, in a fixed order
+using quad = tuple<float, float, float, float, uint32_t>;
+vector<quad> quads(const vector<vertex> &vs, size_t per_quad) {
+  vector<quad> result;
+  for (size_t i = 0; i < vs.size(); i += per_quad) {
+    float x0 = vs[i].x, y0 = vs[i].y, x1 = x0, y1 = y0;
+    for (size_t j = i; j < i + per_quad; ++j) {
+      x0 = min(x0, vs[j].x);
+      y0 = min(y0, vs[j].y);
+      x1 = max(x1, vs[j].x);
+      y1 = max(y1, vs[j].y);
+    }
+    uint32_t colour = static_cast<uint32_t>(vs[i].a) << 24 |
+                      static_cast<uint32_t>(vs[i].r) << 16 |
+                      static_cast<uint32_t>(vs[i].g) << 8 | vs[i].b;
+    result.emplace_back(x0, y0, x1, y1, colour);
+  }
+  sort(result.begin(), result.end());
+  return result;
+}
+
+struct timing {
+  double ms_per_frame;
+  size_t draw_calls;
+  vector<quad> frame;
+};
+
+template <typename Draw>
+timing time_frames(headless_window &window, int frames, size_t per_quad,
+                   Draw draw) {
+  auto start = steady_clock::now();
+  for (int f = 0; f < frames; ++f) {
+    window.begin_frame();
+    draw();
+  }
+  duration<double, milli> elapsed = steady_clock::now() - start;
+  return {elapsed.count() / frames, window.draw_calls,
+          quads(window.submitted, per_quad)};
+}
+
+int main() {
+  cout << setw(10) << "bricks" << setw(16) << "per entity" << setw(18)
+       << "batch, objects" << setw(16) << "batch, arrays" << setw(16)
+       << "draw calls" << setw(8) << "same" << "\n";
+  cout << setw(10) << "" << setw(16) << "ms/frame" << setw(18) << "ms/frame"
+       << setw(16) << "ms/frame" << setw(16) << "each/batched" << "\n";
+
+  for (int bricks : {1000, 10000, 100000}) {
+    int frames = max(20, 2000000 / bricks);
+
+    drawn_manager drawn;
+    entity_manager plain;
+    soa::entity_manager tables;
+    for (int i = 0; i < bricks; ++i) {
+      vec2 p = brick_position(i);
+      drawn.create<drawn_brick>(p.x, p.y, brick_texture)
+          .set_strength(brick_strength(i));
+      plain.create<brick>(p.x, p.y).set_strength(brick_strength(i));
+      tables.get(tables.create<soa::brick>(p.x, p.y)).strength() =
+          brick_strength(i);
+    }
+    for (int i = 0; i < balls; ++i) {
+      vec2 p = ball_position(i);
+      drawn.create<drawn_ball>(p.x, p.y, ball_texture);
+      plain.create<ball>(p.x, p.y);
+      tables.create<soa::ball>(p.x, p.y);
+    }
+    drawn.create<drawn_paddle>(paddle_position.x, paddle_position.y,
+                               paddle_texture);
+    plain.create<paddle>(paddle_position.x, paddle_position.y);
+    tables.create<soa::paddle>(paddle_position.x, paddle_position.y);
+    // the colours follow the strengths
+    drawn.apply_all<drawn_brick>([](drawn_brick &b) { b.update(); });
+    plain.apply_all<brick>([](brick &b) { b.update(); });
+    soa::update_bricks(tables.get_all<soa::brick>());
+
+    headless_window window;
+    timing each = time_frames(window, frames, 4, [&] {
+      drawn.apply_all<drawn_brick>([&](drawn_brick &b) { b.draw(window); });
+      drawn.apply_all<drawn_ball>([&](drawn_ball &b) { b.draw(window); });
+      drawn.apply_all<drawn_paddle>(
+          [&](drawn_paddle &p) { p.draw(window); });
+    });
+
+    sprite_batch batch;
+    auto brick_id = batch.add_texture(brick_texture.size);
+    auto ball_id = batch.add_texture(ball_texture.size);
+    auto paddle_id = batch.add_texture(paddle_texture.size);
+    const texture *textures[] = {&brick_texture, &ball_texture,
+                                 &paddle_texture};
+    auto submit = [&] {
+      for (size_t t = 0; t < batch.texture_count(); ++t) {
+        if (!batch.vertices(t).empty()) {
+          window.draw(batch.vertices(t), textures[t]);
+        }
+      }
+    };
+    const uint32_t white = 0xffffffff;
+
+    timing objects = time_frames(window, frames, 6, [&] {
+      batch.clear();
+      plain.apply_all<brick>(
+          [&](brick &b) { batch.add(brick_id, b, b.get_colour()); });
+      plain.apply_all<ball>([&](ball &b) { batch.add(ball_id, b, white); });
+      plain.apply_all<paddle>(
+          [&](paddle &p) { batch.add(paddle_id, p, white); });
+      submit();
+    });
+
+    timing arrays = time_frames(window, frames, 6, [&] {
+      batch.clear();
+      batch.add_all(brick_id, tables.get_all<soa::brick>());
+      batch.add_all(ball_id, tables.get_all<soa::ball>());
+      batch.add_all(paddle_id, tables.get_all<soa::paddle>());
+      submit();
+    });
+
+    bool same = each.frame == objects.frame && each.frame == arrays.frame;
+    cout << setw(10) << bricks << fixed << setprecision(3) << setw(16)
+         << each.ms_per_frame << setw(18) << objects.ms_per_frame << setw(16)
+         << arrays.ms_per_frame << defaultfloat << setw(10)
+         << each.draw_calls << "/" << left << setw(5) << arrays.draw_calls
+         << right << setw(8) << (same ? "yes" : "NO") << "\n";
+  }
+}
@@ -0,0 +1,192 @@
+#include "batch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+
+using namespace std;
+
+namespace {
+
+// a fixed capacity FIFO shared between threads
+// push blocks while the queue is full, pop blocks while it is empty, and
+// after close() pop returns nothing once the queue has drained
+template <typename T> class bounded_queue {
+
+private:
+  mutex m;
+  condition_variable not_full;
+  condition_variable not_empty;
+  deque<T> items;
+  size_t capacity;
+  bool closed{false};
+
+public:
+  explicit bounded_queue(size_t capacity)
+      : capacity(max<size_t>(capacity, 1)) {}
+
+  void push(T item) {
+    unique_lock lock(m);
+    not_full.wait(lock, [this] { return items.size() < capacity; });
+    items.push_back(std::move(item));
+    not_empty.notify_one();
+  }
+
+  optional<T> pop() {
+    unique_lock lock(m);
+    not_empty.wait(lock, [this] { return !items.empty() || closed; });
+    if (items.empty()) {
+      return nullopt;
+    }
+    T item = std::move(items.front());
+    items.pop_front();
+    not_full.notify_one();
+    return item;
+  }
+
+  void close() {
+    lock_guard lock(m);
+    closed = true;
+    not_empty.notify_all();
+  }
+};
+
+// job indices for each render thread
+// the owner takes work from the back of its own deque and thieves take from
+// the front, so they only meet when a deque is almost empty. All the work is
+// known up front, so a thread is finished once every deque is empty
+class work_stealing_queues {
+
+private:
+  struct worker_queue {
+    mutex m;
+    deque<size_t> jobs;
+  };
+  vector<worker_queue> queues;
+
+public:
+  work_stealing_queues(size_t workers, size_t jobs) : queues(workers) {
+    for (size_t i = 0; i < jobs; ++i) {
+      queues[i % workers].jobs.push_back(i);
+    }
+  }
+
+  optional<size_t> next(size_t worker) {
+    {
+      auto &own = queues[worker];
+      lock_guard lock(own.m);
+      if (!own.jobs.empty()) {
+        size_t job = own.jobs.back();
+        own.jobs.pop_back();
+        return job;
+      }
+    }
+    for (size_t i = 1; i < queues.size(); ++i) {
+      auto &victim = queues[(worker + i) % queues.size()];
+      lock_guard lock(victim.m);
+      if (!victim.jobs.empty()) {
+        size_t job = victim.jobs.front();
+        victim.jobs.pop_front();
+        return job;
+      }
+    }
+    return nullopt;
+  }
+};
+
+} // namespace
+
+draw_job cpp_logo(string filename, int width, int height) {
+  const int x_mid = width / 2;
+  const int y_mid = height / 2;
+  const int x_unit = x_mid / 4;
+  const int y_unit = y_mid / 4;
+  const pixel cyan{255, 255, 25};
+
+  draw_job job{std::move(filename), width, height, {127, 127, 127}, {}};
+  job.shapes = {
+      // stem of "C"
+      {0, 0, x_unit, height, cyan},
+      // top and bottom of "C"
+      {x_unit, 0, x_mid, y_unit, cyan},
+      {x_unit, height - y_unit, x_mid, height, cyan},
+      // first +
+      {x_mid - (2 * x_unit), y_mid - (y_unit / 2), x_mid, y_mid + (y_unit / 2),
+       cyan},
+      {x_mid - (3 * x_unit / 2), 3 * y_unit, x_mid - (x_unit / 2), 5 * y_unit,
+       cyan},
+      // second +
+      {5 * x_unit, y_mid - (y_unit / 2), 7 * x_unit, y_mid + (y_unit / 2),
+       cyan},
+      {x_mid + (3 * x_unit / 2), 3 * y_unit, x_mid + (5 * x_unit / 2),
+       5 * y_unit, cyan},
+  };
+  return job;
+}
+
+bitmap render(const draw_job &job) {
+  bitmap bmp(job.filename, job.width, job.height);
+  bmp.set_all(job.background);
+  for (const auto &s : job.shapes) {
+    bmp.fill_rect(s.x0, s.y0, s.x1, s.y1, s.colour);
+  }
+  return bmp;
+}
+
+batch_result render_batch(const vector<draw_job> &jobs,
+                          const batch_options &options) {
+  unsigned threads = options.threads;
+  if (threads == 0) {
+    threads = max(thread::hardware_concurrency(), 1u);
+  }
+  // no point in more render threads than jobs
+  threads = static_cast<unsigned>(
+      min<size_t>(threads, max<size_t>(jobs.size(), 1)));
+  size_t depth = options.queue_depth ? options.queue_depth : 2 * threads;
+
+  work_stealing_queues work(threads, jobs.size());
+  bounded_queue<bitmap> finished(depth);
+  atomic<size_t> written{0};
+  atomic<size_t> failed{0};
+
+  // a bitmap that fails to construct (bad dimensions) counts as a failure
+  auto render_loop = [&](size_t worker) {
+    while (auto job = work.next(worker)) {
+      try {
+        finished.push(render(jobs[*job]));
+      } catch (const exception &) {
+        ++failed;
+      }
+    }
+  };
+  auto write_loop = [&] {
+    while (auto bmp = finished.pop()) {
+      if (bmp->write(options.backend)) {
+        ++written;
+      } else {
+        ++failed;
+      }
+    }
+  };
+
+  {
+    vector<jthread> writers;
+    for (unsigned i = 0; i < max(options.writers, 1u); ++i) {
+      writers.emplace_back(write_loop);
+    }
+    {
+      vector<jthread> renderers;
+      for (unsigned i = 0; i < threads; ++i) {
+        renderers.emplace_back(render_loop, i);
+      }
+    } // every render thread has finished here
+    finished.close();
+  } // and every writer has drained the queue here
+
+  return {written.load(), failed.load()};
+}
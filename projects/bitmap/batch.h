@@ -0,0 +1,56 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "bitmap.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// a filled rectangle [x0, x1) x [y0, y1), as passed to bitmap::fill_rect
+struct rect_shape {
+  int x0;
+  int y0;
+  int x1;
+  int y1;
+  pixel colour;
+};
+
+// everything needed to draw one output image
+// the background is filled first, then the shapes in order
+struct draw_job {
+  std::string filename;
+  int width{800};
+  int height{600};
+  pixel background{127, 127, 127};
+  std::vector<rect_shape> shapes;
+};
+
+struct batch_options {
+  unsigned threads{0};   // render threads, 0 means one per core
+  unsigned writers{1};   // threads writing finished images to disk
+  size_t queue_depth{0}; // images waiting to be written, 0 means two per
+                         // render thread
+  write_backend backend{write_backend::stream};
+};
+
+struct batch_result {
+  size_t written{0};
+  size_t failed{0};
+};
+
+// the "C++" logo from main.cpp as a draw job
+draw_job cpp_logo(std::string filename, int width = 800, int height = 600);
+
+// draw a single job into a new bitmap
+bitmap render(const draw_job &job);
+
+// render all the jobs and write them to their files
+// jobs are dealt out to the render threads, and a thread which runs out of
+// work steals from the others. Finished bitmaps go through a bounded queue to
+// the writer threads, so rendering carries on while earlier images are being
+// written, and at most queue_depth finished images are held in memory
+batch_result render_batch(const std::vector<draw_job> &jobs,
+                          const batch_options &options = {});
+
+#endif
@@ -0,0 +1,426 @@
+// Benchmarks for the bitmap fill and write paths, and a check of
+// mapped_bitmap
+// build: g++ -std=c++20 -O2 -pthread bench.cpp bitmap.cpp batch.cpp
+//        mapped_bitmap.cpp -o bench
+// usage: ./bench [fill | write | stream | batch | formats | rle | mapped]
+// peak RSS is per process, so run each write mode separately to compare them
+#include "batch.h"
+#include "bitmap.h"
+#include "mapped_bitmap.h"
+
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+struct resolution {
+  const char *name;
+  int width;
+  int height;
+};
+
+// run f a few times and return the best time in milliseconds
+template <typename F> double best_of(int runs, F f) {
+  double best{1e300};
+  for (int i = 0; i < runs; ++i) {
+    auto start = steady_clock::now();
+    f();
+    duration<double, milli> elapsed = steady_clock::now() - start;
+    best = min(best, elapsed.count());
+  }
+  return best;
+}
+
+void bench_fill() {
+  const resolution sizes[]{
+      {"800x600", 800, 600}, {"4K", 3840, 2160}, {"16K", 15360, 8640}};
+  const unsigned threads = max(thread::hardware_concurrency(), 1u);
+  const pixel p{127, 127, 127};
+
+  cout << "fill whole image, best of 5 (ms)\n";
+  cout << setw(10) << "size" << setw(14) << "set_pixel" << setw(14)
+       << "fill_rect" << setw(14) << "fill_rect/" + to_string(threads)
+       << "\n";
+
+  for (const auto &r : sizes) {
+    bitmap bmp("bench.bmp", r.width, r.height);
+
+    // what main.cpp used to do: one set_pixel call per pixel
+    double per_pixel = best_of(5, [&] {
+      for (int x = 0; x < r.width; ++x) {
+        for (int y = 0; y < r.height; ++y) {
+          bmp.set_pixel(x, y, p);
+        }
+      }
+    });
+    double spans =
+        best_of(5, [&] { bmp.fill_rect(0, 0, r.width, r.height, p); });
+    double banded = best_of(
+        5, [&] { bmp.fill_rect(0, 0, r.width, r.height, p, threads); });
+
+    cout << fixed << setprecision(2) << setw(10) << r.name << setw(14)
+         << per_pixel << setw(14) << spans << setw(14) << banded << "\n";
+  }
+}
+
+// largest resident set size of this process so far, in MB
+double peak_rss_mb() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss / 1024.0; // ru_maxrss is in KB on Linux
+}
+
+void report(const char *name, double ms, double bytes) {
+  cout << fixed << setprecision(2) << name << ": " << ms << " ms, "
+       << bytes / (1024 * 1024) / (ms / 1000) << " MB/s, peak RSS "
+       << peak_rss_mb() << " MB\n";
+}
+
+constexpr int write_width = 15360;
+constexpr int write_height = 8640;
+
+// the whole 16K image is built in memory and then written with each backend
+// the time to fsync afterwards is reported separately, since the buffered
+// backends only reach the page cache while direct goes to the device
+void bench_write() {
+  const struct {
+    const char *name;
+    write_backend backend;
+  } backends[]{{"stream", write_backend::stream},
+               {"vectored", write_backend::vectored},
+               {"direct", write_backend::direct}};
+
+  auto start = steady_clock::now();
+  bitmap bmp("bench.bmp", write_width, write_height);
+  for (int y = 0; y < write_height; ++y) {
+    bmp.set_row(y, pixel{static_cast<uint8_t>(y), 127, 127});
+  }
+  duration<double, milli> elapsed = steady_clock::now() - start;
+  cout << fixed << setprecision(2) << "build image: " << elapsed.count()
+       << " ms\n";
+
+  double bytes = static_cast<double>(write_height) * write_width * 3;
+  for (const auto &b : backends) {
+    start = steady_clock::now();
+    bool ok = bmp.write(b.backend);
+    duration<double, milli> written = steady_clock::now() - start;
+    int fd = open("bench.bmp", O_RDONLY);
+    fsync(fd);
+    close(fd);
+    duration<double, milli> synced = steady_clock::now() - start;
+    if (!ok) {
+      cout << b.name << ": write failed\n";
+      continue;
+    }
+    report(b.name, written.count(), bytes);
+    cout << "  with fsync: " << synced.count() << " ms, "
+         << bytes / (1024 * 1024) / (synced.count() / 1000) << " MB/s\n";
+  }
+}
+
+// the same image produced one band at a time
+void bench_stream() {
+  auto start = steady_clock::now();
+  bitmap_stream_writer writer("bench.bmp", write_width, write_height);
+  bool ok = writer.write([](const pixel_band &band) {
+    for (int i = 0; i < band.rows; ++i) {
+      pixel p{static_cast<uint8_t>(band.first_row + i), 127, 127};
+      pixel *row = band.row(i);
+      for (int x = 0; x < band.width; ++x) {
+        row[x] = p;
+      }
+    }
+  });
+  duration<double, milli> elapsed = steady_clock::now() - start;
+  if (!ok) {
+    cout << "write failed\n";
+    return;
+  }
+  double bytes = static_cast<double>(write_height) * write_width * 3;
+  report("bitmap_stream_writer", elapsed.count(), bytes);
+}
+
+// images per second for a batch of 1080p logos against the render thread
+// count, with one writer thread behind a bounded queue
+void bench_batch() {
+  const int images = 48;
+  const filesystem::path dir = "batch_out";
+  filesystem::create_directory(dir);
+
+  vector<draw_job> jobs;
+  for (int i = 0; i < images; ++i) {
+    auto name = dir / ("logo_" + to_string(i) + ".bmp");
+    jobs.push_back(cpp_logo(name.string(), 1920, 1080));
+  }
+
+  const unsigned cores = max(thread::hardware_concurrency(), 1u);
+  cout << images << " images of 1920x1080, " << cores << " cores\n";
+  cout << setw(10) << "threads" << setw(14) << "images/s" << "\n";
+  for (unsigned threads = 1; threads <= 2 * cores; threads *= 2) {
+    batch_options options;
+    options.threads = threads;
+    auto start = steady_clock::now();
+    batch_result result = render_batch(jobs, options);
+    duration<double> elapsed = steady_clock::now() - start;
+    cout << setw(10) << threads << setw(14) << fixed << setprecision(1)
+         << result.written / elapsed.count();
+    if (result.failed) {
+      cout << "  (" << result.failed << " failed)";
+    }
+    cout << "\n";
+  }
+
+  filesystem::remove_all(dir);
+}
+
+// draw the 4K logo in one pixel format and write it
+template <typename Format>
+void bench_format(const char *name, typename Format::value_type background,
+                  typename Format::value_type logo) {
+  const int width = 3840;
+  const int height = 2160;
+  auto start = steady_clock::now();
+  basic_bitmap<Format> bmp("bench.bmp", width, height);
+  if constexpr (Format::palette_size > 0) {
+    bmp.set_colour(0, pixel{127, 127, 127});
+    bmp.set_colour(1, pixel{255, 255, 25});
+  }
+  bmp.set_all(background);
+  for (const auto &s : cpp_logo("", width, height).shapes) {
+    bmp.fill_rect(s.x0, s.y0, s.x1, s.y1, logo);
+  }
+  bool ok = bmp.write();
+  duration<double, milli> elapsed = steady_clock::now() - start;
+  if (!ok) {
+    cout << name << ": write failed\n";
+    return;
+  }
+  cout << setw(10) << name << setw(14) << fixed << setprecision(2)
+       << elapsed.count() << setw(14) << filesystem::file_size("bench.bmp")
+       << "\n";
+}
+
+// the two colour logo at 4K in every pixel format
+void bench_formats() {
+  cout << setw(10) << "format" << setw(14) << "draw+write ms" << setw(14)
+       << "file bytes" << "\n";
+  bench_format<bgr24>("bgr24", {127, 127, 127}, {255, 255, 25});
+  bench_format<bgra32>("bgra32", {127, 127, 127, 0}, {255, 255, 25, 0});
+  bench_format<indexed8>("indexed8", 0, 1);
+  bench_format<indexed4>("indexed4", 0, 1);
+  bench_format<indexed1>("indexed1", 0, 1);
+}
+
+// write time and file size of the 4K logo, uncompressed and run length
+// encoded
+template <typename Format> void bench_rle_format(const char *name) {
+  const int width = 3840;
+  const int height = 2160;
+  basic_bitmap<Format> bmp("bench.bmp", width, height);
+  bmp.set_colour(0, pixel{127, 127, 127});
+  bmp.set_colour(1, pixel{255, 255, 25});
+  bmp.set_all(0);
+  for (const auto &s : cpp_logo("", width, height).shapes) {
+    bmp.fill_rect(s.x0, s.y0, s.x1, s.y1, 1);
+  }
+
+  const struct {
+    const char *name;
+    bitmap_compression compression;
+  } modes[]{{"none", bitmap_compression::none},
+            {"rle", bitmap_compression::rle}};
+  for (const auto &m : modes) {
+    double ms = best_of(5, [&] { bmp.write(m.compression); });
+    cout << setw(10) << name << setw(8) << m.name << setw(14) << fixed
+         << setprecision(2) << ms << setw(14)
+         << filesystem::file_size("bench.bmp") << "\n";
+  }
+}
+
+void bench_rle() {
+  cout << setw(10) << "format" << setw(8) << "mode" << setw(14) << "write ms"
+       << setw(14) << "file bytes" << "\n";
+  bench_rle_format<indexed8>("indexed8");
+  bench_rle_format<indexed4>("indexed4");
+}
+
+vector<uint8_t> read_file(const string &filename) {
+  ifstream ifile(filename, fstream::binary);
+  return vector<uint8_t>(istreambuf_iterator<char>(ifile),
+                         istreambuf_iterator<char>());
+}
+
+void write_file(const string &filename, const vector<uint8_t> &bytes) {
+  ofstream ofile(filename, fstream::binary);
+  ofile.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+}
+
+bool same(pixel a, pixel b) {
+  return a.blue == b.blue && a.green == b.green && a.red == b.red;
+}
+
+bool throws(const string &filename) {
+  try {
+    mapped_bitmap m(filename);
+  } catch (const runtime_error &) {
+    return true;
+  }
+  return false;
+}
+
+// where the fields that the checks change are in the file
+constexpr size_t height_offset = sizeof(bitmap_file_header) + 8;
+constexpr size_t compression_offset = sizeof(bitmap_file_header) + 16;
+constexpr size_t data_offset =
+    sizeof(bitmap_file_header) + sizeof(bitmap_info_header);
+
+// opens the file in place, checks it matches the source bitmap, then edits
+// it and checks the edits are in the file where they should be
+bool check_mapped_file(const string &filename, const bitmap &source,
+                       bool top_down) {
+  int width = source.get_width();
+  int height = source.get_height();
+  size_t stride = (width * sizeof(pixel) + 3) / 4 * 4;
+  const pixel edit{1, 2, 3};
+  const pixel row_colour{9, 8, 7};
+  const int edit_x = 5, edit_y = 3, edit_row = 10;
+  {
+    mapped_bitmap m(filename);
+    if (m.get_width() != width || m.get_height() != height) {
+      return false;
+    }
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        if (!same(m.get_pixel(x, y), source.get_pixel(x, y))) {
+          return false;
+        }
+      }
+    }
+    m.set_pixel(edit_x, edit_y, edit);
+    m.set_row(edit_row, row_colour);
+    if (!m.flush()) {
+      return false;
+    }
+  }
+
+  vector<uint8_t> bytes = read_file(filename);
+  auto at = [&](int x, int y) {
+    int file_row = top_down ? height - 1 - y : y;
+    pixel p;
+    memcpy(&p, &bytes[data_offset + file_row * stride + x * sizeof(pixel)],
+           sizeof p);
+    return p;
+  };
+  if (!same(at(edit_x, edit_y), edit) ||
+      !same(at(edit_x + 1, edit_y), source.get_pixel(edit_x + 1, edit_y))) {
+    return false;
+  }
+  for (int x = 0; x < width; ++x) {
+    if (!same(at(x, edit_row), row_colour) ||
+        !same(at(x, edit_row + 1), source.get_pixel(x, edit_row + 1))) {
+      return false;
+    }
+  }
+  // set_row mustn't spill into the row's padding
+  int file_row = top_down ? height - 1 - edit_row : edit_row;
+  for (size_t i = width * sizeof(pixel); i < stride; ++i) {
+    if (bytes[data_offset + file_row * stride + i] != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int check_mapped() {
+  bool ok = true;
+  auto check = [&ok](const char *what, bool passed) {
+    cout << setw(44) << left << what << (passed ? "yes" : "NO") << right
+         << "\n";
+    ok = ok && passed;
+  };
+
+  // 37 pixels is 111 bytes, so every row has a byte of padding
+  const int width = 37, height = 23;
+  bitmap source("mapped.bmp", width, height);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      source.set_pixel(x, y,
+                       pixel{static_cast<uint8_t>(x * 5),
+                             static_cast<uint8_t>(y * 7),
+                             static_cast<uint8_t>(x + y)});
+    }
+  }
+  source.write();
+  const vector<uint8_t> bottom_up = read_file("mapped.bmp");
+  check("bottom-up file maps, reads and edits",
+        check_mapped_file("mapped.bmp", source, false));
+
+  // the same image top-down: a negative height and the rows reversed
+  size_t stride = (width * sizeof(pixel) + 3) / 4 * 4;
+  vector<uint8_t> top_down = bottom_up;
+  int32_t negative = -height;
+  memcpy(&top_down[height_offset], &negative, sizeof negative);
+  for (int y = 0; y < height; ++y) {
+    memcpy(&top_down[data_offset + y * stride],
+           &bottom_up[data_offset + (height - 1 - y) * stride], stride);
+  }
+  write_file("mapped.bmp", top_down);
+  check("top-down file maps, reads and edits",
+        check_mapped_file("mapped.bmp", source, true));
+
+  write_file("mapped.bmp", vector<uint8_t>(bottom_up.begin(),
+                                           bottom_up.end() - stride / 2));
+  check("truncated file is refused", throws("mapped.bmp"));
+
+  vector<uint8_t> compressed = bottom_up;
+  compressed[compression_offset] = 1;
+  write_file("mapped.bmp", compressed);
+  check("compressed file is refused", throws("mapped.bmp"));
+
+  basic_bitmap<bgra32> wide("mapped.bmp", width, height);
+  wide.write();
+  check("32 bit file is refused", throws("mapped.bmp"));
+
+  filesystem::remove("mapped.bmp");
+  return ok ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  string mode = argc > 1 ? argv[1] : "fill";
+  if (mode == "fill") {
+    bench_fill();
+  } else if (mode == "write") {
+    bench_write();
+  } else if (mode == "stream") {
+    bench_stream();
+  } else if (mode == "batch") {
+    bench_batch();
+  } else if (mode == "formats") {
+    bench_formats();
+  } else if (mode == "rle") {
+    bench_rle();
+  } else if (mode == "mapped") {
+    return check_mapped();
+  } else {
+    cout << "usage: " << argv[0]
+         << " [fill | write | stream | batch | formats | rle | mapped]\n";
+    return 1;
+  }
+}
@@ -1,29 +1,61 @@
 #include "bitmap.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
 #include <fstream>
+#include <stdexcept>
+#include <sys/uio.h>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
 
 using namespace std;
 
-bool bitmap::write() {
-  bitmap_file_header file_header;
-  bitmap_info_header info_header;
+static_assert(sizeof(pixel) == 3, "pixel must be packed BGR");
+
+namespace {
+
+// a band of rows should be worth at least this many pixels before it is
+// handed to its own thread, otherwise starting the thread costs more than the
+// fill itself
+constexpr size_t min_pixels_per_thread = 1 << 18;
+
+// round n up to the next multiple of m
+constexpr size_t round_up(size_t n, size_t m) { return (n + m - 1) / m * m; }
+
+constexpr size_t headers_size =
+    sizeof(bitmap_file_header) + sizeof(bitmap_info_header);
+
+// fill in both headers for an image with data_size bytes of pixel rows
+// a palette of colours entries sits between the headers and the pixels
+void make_headers(bitmap_file_header &file_header,
+                  bitmap_info_header &info_header, int width, int height,
+                  int bits_per_pixel, int colours, size_t data_size) {
+  size_t palette_size = colours * sizeof(pixel_bgra);
 
   // calculate the size of the bitmap
-  file_header.file_size = sizeof(bitmap_file_header) +
-                          sizeof(bitmap_info_header) +
-                          width * height * sizeof(pixel);
+  // rows in the file are padded to a multiple of 4 bytes
+  file_header.file_size = headers_size + palette_size + data_size;
 
-  file_header.data_offset =
-      sizeof(bitmap_file_header) + sizeof(bitmap_info_header);
+  file_header.data_offset = headers_size + palette_size;
 
   // set the image width and height
   info_header.width = width;
   info_header.height = height;
+  info_header.bits_per_pixel = bits_per_pixel;
+  info_header.colours = colours;
+  info_header.data_size = data_size;
+}
 
-  // open the file where we will write the bitmap
-  ofstream ofile(filename, fstream::out | fstream::binary);
-  if (!ofile.is_open()) {
-    return false;
-  }
+// the headers for a 24 bit image
+void write_headers(ofstream &ofile, int width, int height, size_t data_size) {
+  bitmap_file_header file_header;
+  bitmap_info_header info_header;
+  make_headers(file_header, info_header, width, height, 24, 0, data_size);
 
   // write the file header
   ofile.write(reinterpret_cast<char *>(&file_header),
@@ -31,11 +63,217 @@ bool bitmap::write() {
   // write the info header
   ofile.write(reinterpret_cast<char *>(&info_header),
               sizeof(bitmap_info_header));
+}
+
+// writev all of iov, at most IOV_MAX entries per call, carrying on after a
+// short write. The entries are updated to track progress
+bool write_all(int fd, iovec *iov, size_t count) {
+  while (count > 0) {
+    ssize_t n = writev(fd, iov, static_cast<int>(min<size_t>(count, IOV_MAX)));
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    // skip the entries which were written completely
+    size_t done = n;
+    while (count > 0 && done >= iov->iov_len) {
+      done -= iov->iov_len;
+      ++iov;
+      --count;
+    }
+    if (count > 0) {
+      iov->iov_base = static_cast<uint8_t *>(iov->iov_base) + done;
+      iov->iov_len -= done;
+    }
+  }
+  return true;
+}
+
+bool write_all(int fd, const uint8_t *data, size_t size) {
+  iovec iov{const_cast<uint8_t *>(data), size};
+  return write_all(fd, &iov, 1);
+}
+
+// formats which have a BMP run length encoding
+template <typename Format>
+constexpr bool can_rle =
+    is_same_v<Format, indexed8> || is_same_v<Format, indexed4>;
+
+// append one row of RLE8 or RLE4 codes to out, without the end of line
+// a run of three or more equal pixels becomes an encoded run (count, index)
+// and the pixels between runs go out in absolute mode (0, count, indices),
+// padded to a 16 bit boundary. Absolute mode needs at least three pixels, so
+// shorter stretches are sent as encoded runs of one or two. In RLE4 the index
+// of an encoded run is repeated in both nibbles
+template <typename Format>
+void encode_rle_row(const uint8_t *row, int width, vector<uint8_t> &out) {
+  constexpr int max_run = 255;
+  constexpr bool nibbles = Format::bits_per_pixel == 4;
+
+  auto run_at = [&](int x) {
+    uint8_t v = Format::load(row, x);
+    int n = 1;
+    while (x + n < width && n < max_run && Format::load(row, x + n) == v) {
+      ++n;
+    }
+    return n;
+  };
+  auto encoded = [&](int count, uint8_t v) {
+    out.push_back(static_cast<uint8_t>(count));
+    out.push_back(nibbles ? static_cast<uint8_t>(v << 4 | v) : v);
+  };
+
+  int x = 0;
+  while (x < width) {
+    int run = run_at(x);
+    if (run >= 3) {
+      encoded(run, Format::load(row, x));
+      x += run;
+      continue;
+    }
+
+    // gather pixels up to the start of the next long run
+    int start = x;
+    while (x < width && x - start < max_run && run_at(x) < 3) {
+      x += 1;
+    }
+    int count = x - start;
+    if (count < 3) {
+      for (int i = start; i < x; i += run) {
+        run = min(run_at(i), x - i);
+        encoded(run, Format::load(row, i));
+      }
+      continue;
+    }
+
+    out.push_back(0);
+    out.push_back(static_cast<uint8_t>(count));
+    size_t literal = out.size();
+    for (int i = start; i < x; ++i) {
+      uint8_t v = Format::load(row, i);
+      if (!nibbles) {
+        out.push_back(v);
+      } else if ((i - start) % 2 == 0) {
+        out.push_back(static_cast<uint8_t>(v << 4));
+      } else {
+        out.back() |= v;
+      }
+    }
+    if ((out.size() - literal) % 2 != 0) {
+      out.push_back(0);
+    }
+  }
+}
+
+} // namespace
+
+// write n copies of p starting at dst
+// the first 16 pixels are stored one by one, which gives a 48 byte block that
+// holds a whole number of BGR triples. After that the filled part of the span
+// is copied onto the rest of it, doubling each time, so every store is a
+// memcpy which the compiler turns into wide vector stores
+void fill_span(pixel *dst, size_t n, pixel p) {
+  constexpr size_t block = 16;
+  size_t done = min(n, block);
+  for (size_t i = 0; i < done; ++i) {
+    dst[i] = p;
+  }
+  while (done < n) {
+    size_t chunk = min(done, n - done);
+    memcpy(dst + done, dst, chunk * sizeof(pixel));
+    done += chunk;
+  }
+}
+
+pixel_storage::pixel_storage(int width, int height, int bits_per_pixel,
+                             size_t prefix_bytes)
+    : rows(height) {
+  if (width < 1 || height < 1 || width > max_dimension ||
+      height > max_dimension) {
+    throw invalid_argument("bitmap dimensions must be between 1 and " +
+                           to_string(max_dimension));
+  }
+  size_t row_bytes = (static_cast<size_t>(width) * bits_per_pixel + 7) / 8;
+  row_file_stride = round_up(row_bytes, 4);
+  // checked before anything is allocated
+  if (prefix_bytes + file_bytes() > UINT32_MAX) {
+    throw invalid_argument("bitmap too big for a BMP file, which must be "
+                           "under 4 GiB");
+  }
+  row_stride = round_up(row_file_stride, alignment);
+  // value-initialised, so all the padding starts out as zero
+  data.reset(new (align_val_t{alignment}) uint8_t[row_stride * rows]());
+}
+
+// both headers and the palette, as they appear at the start of the file
+template <typename Format>
+vector<uint8_t> basic_bitmap<Format>::file_prefix(int compression,
+                                                  size_t data_size) const {
+  bitmap_file_header file_header;
+  bitmap_info_header info_header;
+  make_headers(file_header, info_header, width, height, Format::bits_per_pixel,
+               Format::palette_size, data_size);
+  info_header.compression = compression;
+
+  vector<uint8_t> prefix(file_header.data_offset);
+  memcpy(prefix.data(), &file_header, sizeof(file_header));
+  memcpy(prefix.data() + sizeof(file_header), &info_header,
+         sizeof(info_header));
+  if constexpr (Format::palette_size > 0) {
+    memcpy(prefix.data() + headers_size, palette.data(),
+           palette.size() * sizeof(pixel_bgra));
+  }
+  return prefix;
+}
+
+template <typename Format>
+bool basic_bitmap<Format>::write(write_backend backend) {
+  switch (backend) {
+  case write_backend::vectored:
+    return write_vectored();
+  case write_backend::direct:
+    return write_direct();
+  default:
+    return write_stream();
+  }
+}
+
+template <typename Format>
+bool basic_bitmap<Format>::write(bitmap_compression compression) {
+  if constexpr (can_rle<Format>) {
+    if (compression != bitmap_compression::none) {
+      return write_rle(compression == bitmap_compression::automatic);
+    }
+  }
+  return write_stream();
+}
+
+template <typename Format> bool basic_bitmap<Format>::write_stream() {
+  // open the file where we will write the bitmap
+  ofstream ofile(filename, fstream::out | fstream::binary);
+  if (!ofile.is_open()) {
+    return false;
+  }
+
+  // write the headers and the palette
+  vector<uint8_t> prefix = file_prefix(0, pixels.file_bytes());
+  ofile.write(reinterpret_cast<const char *>(prefix.data()), prefix.size());
 
   // the first argument to write is an array containing the image data
   // the second argument is the size of the data
-  ofile.write(reinterpret_cast<char *>(pixels.data()),
-              pixels.size() * sizeof(pixel));
+  // rows are further apart in memory than in the file, so unless the two
+  // strides happen to match each padded row is written on its own
+  if (pixels.stride() == pixels.file_stride()) {
+    ofile.write(reinterpret_cast<const char *>(pixels.row(0)),
+                pixels.file_bytes());
+  } else {
+    for (int y = 0; y < height; ++y) {
+      ofile.write(reinterpret_cast<const char *>(pixels.row(y)),
+                  pixels.file_stride());
+    }
+  }
 
   if (!ofile) {
     return false;
@@ -44,20 +282,252 @@ bool bitmap::write() {
   return true;
 }
 
-void bitmap::set_pixel(int x, int y, pixel p) {
-  int idx = y * width + x; // calculate pixel offset
-  pixels[idx] = p;         // the vector index is the pixel offset
+template <typename Format> bool basic_bitmap<Format>::write_vectored() {
+  int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+
+  vector<uint8_t> prefix = file_prefix(0, pixels.file_bytes());
+
+  // one entry for the headers and palette, then the padded rows straight out
+  // of the pixel storage, or a single entry if the rows are contiguous
+  vector<iovec> iov;
+  iov.push_back({prefix.data(), prefix.size()});
+  if (pixels.stride() == pixels.file_stride()) {
+    iov.push_back({pixels.row(0), pixels.file_bytes()});
+  } else {
+    iov.reserve(height + 1);
+    for (int y = 0; y < height; ++y) {
+      iov.push_back({pixels.row(y), pixels.file_stride()});
+    }
+  }
+
+  bool ok = write_all(fd, iov.data(), iov.size());
+  return ::close(fd) == 0 && ok;
+}
+
+template <typename Format> bool basic_bitmap<Format>::write_direct() {
+#ifdef O_DIRECT
+  int fd =
+      ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+  if (fd < 0 && errno == EINVAL) {
+    return write_vectored(); // the file system doesn't do O_DIRECT
+  }
+  if (fd < 0) {
+    return false;
+  }
+
+  // O_DIRECT needs the buffer, the length and the file offset all aligned to
+  // the device block size. The headers put the rows out of step with that,
+  // so everything is staged through an aligned buffer which is written out
+  // whenever it fills up
+  constexpr size_t block = 4096;
+  constexpr size_t staging_size = 8 << 20;
+  unique_ptr<uint8_t, decltype(&free)> staging(
+      static_cast<uint8_t *>(aligned_alloc(block, staging_size)), &free);
+  if (!staging) {
+    ::close(fd);
+    return false;
+  }
+
+  uint8_t *buffer = staging.get();
+  size_t used = 0;
+  size_t total = 0;
+  bool ok = true;
+  auto append = [&](const uint8_t *src, size_t n) {
+    while (ok && n > 0) {
+      size_t chunk = min(n, staging_size - used);
+      memcpy(buffer + used, src, chunk);
+      used += chunk;
+      total += chunk;
+      src += chunk;
+      n -= chunk;
+      if (used == staging_size) {
+        ok = write_all(fd, buffer, used);
+        used = 0;
+      }
+    }
+  };
+
+  vector<uint8_t> prefix = file_prefix(0, pixels.file_bytes());
+  append(prefix.data(), prefix.size());
+  for (int y = 0; y < height && ok; ++y) {
+    append(pixels.row(y), pixels.file_stride());
+  }
+
+  // the last block is padded out to the block size, and the file is then
+  // cut back to its real length
+  if (ok && used > 0) {
+    size_t padded = round_up(used, block);
+    memset(buffer + used, 0, padded - used);
+    ok = write_all(fd, buffer, padded);
+  }
+  if (ok) {
+    ok = ftruncate(fd, static_cast<off_t>(total)) == 0;
+  }
+  return ::close(fd) == 0 && ok;
+#else
+  return write_vectored();
+#endif
 }
 
 // set all the pixels in an entire row
-void bitmap::set_row(int row, pixel p) {
-  for (int i = 0; i < width; ++i) {
-    set_pixel(i, row, p);
+template <typename Format>
+void basic_bitmap<Format>::set_row(int row, value_type v) {
+  fill_rows(row, row + 1, v);
+}
+
+template <typename Format> void basic_bitmap<Format>::set_all(value_type v) {
+  fill_rows(0, height, v);
+}
+
+template <typename Format>
+void basic_bitmap<Format>::fill_rows(int y0, int y1, value_type v,
+                                     unsigned threads) {
+  fill_rect(0, y0, width, y1, v, threads);
+}
+
+// fill each row of the band as a span
+template <typename Format>
+void basic_bitmap<Format>::fill_band(int x0, int x1, int y0, int y1,
+                                     value_type v) {
+  for (int y = y0; y < y1; ++y) {
+    Format::fill(pixels.row(y), x0, x1, v);
+  }
+}
+
+template <typename Format>
+void basic_bitmap<Format>::fill_rect(int x0, int y0, int x1, int y1,
+                                     value_type v, unsigned threads) {
+  // clip the rectangle to the image
+  x0 = max(x0, 0);
+  y0 = max(y0, 0);
+  x1 = min(x1, width);
+  y1 = min(y1, height);
+  if (x0 >= x1 || y0 >= y1) {
+    return;
+  }
+
+  // do not start more threads than there are rows or than the work justifies
+  size_t rows = y1 - y0;
+  size_t area = rows * (x1 - x0);
+  size_t useful = max<size_t>(area / min_pixels_per_thread, 1);
+  size_t bands = min({static_cast<size_t>(max(threads, 1u)), useful, rows});
+
+  if (bands == 1) {
+    fill_band(x0, x1, y0, y1, v);
+    return;
+  }
+
+  // each thread gets a contiguous band of rows, so no two threads ever
+  // write to the same row
+  vector<jthread> workers;
+  workers.reserve(bands - 1);
+  int y = y0;
+  for (size_t b = 0; b < bands; ++b) {
+    int band_end = y0 + static_cast<int>(rows * (b + 1) / bands);
+    if (b + 1 == bands) {
+      fill_band(x0, x1, y, band_end, v); // the calling thread takes the last
+    } else {
+      workers.emplace_back([this, x0, x1, y, band_end, v] {
+        fill_band(x0, x1, y, band_end, v);
+      });
+    }
+    y = band_end;
   }
 }
 
-void bitmap::set_all(pixel p) {
-  for (int i = 0; i < height; ++i) {
-    set_row(i, p);
+// the encoded rows go out one at a time, so the only extra memory is one
+// encoded row. The headers are written first with a zero size and filled in
+// once the size is known. In automatic mode the encoding is abandoned, and the
+// file rewritten uncompressed, as soon as it grows as big as the
+// uncompressed rows would be
+template <typename Format>
+bool basic_bitmap<Format>::write_rle(bool automatic) {
+  if constexpr (can_rle<Format>) {
+    ofstream ofile(filename, fstream::out | fstream::binary);
+    if (!ofile.is_open()) {
+      return false;
+    }
+
+    constexpr int compression = Format::bits_per_pixel == 8 ? 1 : 2;
+    vector<uint8_t> prefix = file_prefix(compression, 0);
+    ofile.write(reinterpret_cast<const char *>(prefix.data()), prefix.size());
+
+    vector<uint8_t> encoded;
+    size_t data_size = 0;
+    for (int y = 0; y < height && ofile; ++y) {
+      encoded.clear();
+      encode_rle_row<Format>(pixels.row(y), width, encoded);
+      // every row ends with end of line, except the last which ends the
+      // bitmap
+      encoded.push_back(0);
+      encoded.push_back(y + 1 == height ? 1 : 0);
+      ofile.write(reinterpret_cast<const char *>(encoded.data()),
+                  encoded.size());
+      data_size += encoded.size();
+      if (automatic && data_size >= pixels.file_bytes()) {
+        ofile.close();
+        return write_stream();
+      }
+    }
+
+    prefix = file_prefix(compression, data_size);
+    ofile.seekp(0);
+    ofile.write(reinterpret_cast<const char *>(prefix.data()), prefix.size());
+    if (!ofile) {
+      return false;
+    }
+    ofile.close();
+    return true;
+  } else {
+    (void)automatic;
+    return write_stream();
   }
 }
+
+// explicit instantiation of basic_bitmap for every pixel format
+template class basic_bitmap<bgr24>;
+template class basic_bitmap<bgra32>;
+template class basic_bitmap<indexed8>;
+template class basic_bitmap<indexed4>;
+template class basic_bitmap<indexed1>;
+
+bitmap_stream_writer::bitmap_stream_writer(string filename, int width,
+                                           int height, int band_rows)
+    : width(width), height(height), band_rows(max(band_rows, 1)),
+      filename(std::move(filename)) {
+  if (width < 1 || height < 1 || width > pixel_storage::max_dimension ||
+      height > pixel_storage::max_dimension) {
+    throw invalid_argument("bitmap dimensions must be between 1 and " +
+                           to_string(pixel_storage::max_dimension));
+  }
+}
+
+bool bitmap_stream_writer::write(const producer &produce) {
+  ofstream ofile(filename, fstream::out | fstream::binary);
+  if (!ofile.is_open()) {
+    return false;
+  }
+
+  // the band is laid out exactly as the rows are in the file, padding
+  // included, so each band goes to the file with a single write
+  size_t stride = round_up(width * sizeof(pixel), 4);
+  int rows = min(band_rows, height);
+  vector<uint8_t> band(stride * rows); // padding stays zero
+
+  write_headers(ofile, width, height, stride * height);
+
+  for (int first = 0; first < height && ofile; first += rows) {
+    int count = min(rows, height - first);
+    produce(pixel_band{first, count, width, band.data(), stride});
+    ofile.write(reinterpret_cast<const char *>(band.data()), stride * count);
+  }
+
+  if (!ofile) {
+    return false;
+  }
+  ofile.close();
+  return true;
+}
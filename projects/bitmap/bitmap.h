@@ -1,15 +1,22 @@
 #ifndef BITMAP_H
-#define BITMAP_H_
+#define BITMAP_H
 
+#include "pixel_format.h"
+
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
 #include <string>
+#include <utility>
 #include <vector>
 
 #pragma pack(push, 2) // the file header members must start on 16-bit int
 
 struct bitmap_file_header {
   char header[2]{'B', 'M'};
-  int32_t file_size;
+  uint32_t file_size;
   int32_t reserved{0};
   int32_t data_offset;
 };
@@ -23,35 +30,168 @@ struct bitmap_info_header {
   int16_t planes{1};
   int16_t bits_per_pixel{24};
   int32_t compression{0};
-  int32_t data_size{0};
+  uint32_t data_size{0};
   int32_t horizontal_resolution{2400};
   int32_t vertical_resolution{2400};
   int32_t colours{0};
   int32_t important_colours{0};
 };
 
-// although general standars is RGB, but MS used BGR in bitmap which was
-// designed in 80's
-struct pixel {
-  uint8_t blue;
-  uint8_t green;
-  uint8_t red;
+// pixel rows for a bitmap of any size up to max_dimension x max_dimension
+// every row starts on a cache line boundary so that row operations work on
+// aligned memory. A BMP row is padded to a multiple of 4 bytes, and the memory
+// stride is never smaller than that, so the first file_stride() bytes of each
+// row are exactly what goes in the file. The padding is kept zeroed
+// A BMP holds its file size in 32 bits, so the rows plus the prefix_bytes
+// which go before them in the file (headers and palette) must fit in that.
+// A 32768x32768 bgra32 image is already 4 GiB of pixels
+class pixel_storage {
+
+private:
+  struct aligned_delete {
+    void operator()(uint8_t *p) const {
+      ::operator delete[](p, std::align_val_t{alignment});
+    }
+  };
+
+  size_t row_stride{0};
+  size_t row_file_stride{0};
+  int rows{0};
+  std::unique_ptr<uint8_t[], aligned_delete> data;
+
+public:
+  static constexpr size_t alignment = 64;
+  static constexpr int max_dimension = 32768;
+
+  pixel_storage(int width, int height, int bits_per_pixel = 24,
+                size_t prefix_bytes = 0);
+
+  uint8_t *row(int y) { return data.get() + y * row_stride; }
+  const uint8_t *row(int y) const { return data.get() + y * row_stride; }
+  size_t stride() const { return row_stride; }           // bytes in memory
+  size_t file_stride() const { return row_file_stride; } // bytes in the file
+  size_t file_bytes() const { return row_file_stride * rows; }
+};
+
+// how bitmap::write gets the image into the file
+// stream   - through an ofstream
+// vectored - the headers and all the rows in a single writev, so the pixels
+//            go straight from the bitmap to the kernel without a copy
+//            through a stream buffer
+// direct   - O_DIRECT from a page aligned staging buffer, bypassing the page
+//            cache. Falls back to vectored where O_DIRECT isn't supported
+enum class write_backend { stream, vectored, direct };
+
+// how bitmap::write encodes the pixels
+// none      - uncompressed rows
+// rle       - the BMP run length encodings, RLE8 for indexed8 and RLE4 for
+//             indexed4. Other formats are always written uncompressed
+// automatic - rle, unless that turns out no smaller than uncompressed
+enum class bitmap_compression { none, rle, automatic };
+
+// a bitmap whose pixels are stored in the given pixel format
+// (bgr24, bgra32, indexed8, indexed4 or indexed1, see pixel_format.h)
+// the indexed formats also have a palette, which starts out all black
+template <typename Format> class basic_bitmap {
+
+public:
+  using value_type = typename Format::value_type;
+
+private:
+  int width;
+  int height;
+  std::string filename;
+  pixel_storage pixels;
+  std::vector<pixel_bgra> palette;
+
+  void fill_band(int x0, int x1, int y0, int y1, value_type v);
+  // headers and palette
+  std::vector<uint8_t> file_prefix(int compression, size_t data_size) const;
+  bool write_stream();
+  bool write_rle(bool automatic);
+  bool write_vectored();
+  bool write_direct();
+
+public:
+  // throws std::invalid_argument if either dimension is not in
+  // 1..pixel_storage::max_dimension, or the file would be 4 GiB or more
+  basic_bitmap(std::string filename, int width = 800, int height = 600)
+      : width(width), height(height), filename(std::move(filename)),
+        pixels(width, height, Format::bits_per_pixel,
+               sizeof(bitmap_file_header) + sizeof(bitmap_info_header) +
+                   Format::palette_size * sizeof(pixel_bgra)),
+        palette(Format::palette_size) {}
+
+  int get_width() const { return width; }
+  int get_height() const { return height; }
+
+  // set the pixel at (x, y)
+  void set_pixel(int x, int y, value_type v) {
+    Format::store(pixels.row(y), x, v);
+  }
+  value_type get_pixel(int x, int y) const {
+    return Format::load(pixels.row(y), x);
+  }
+  void set_row(int rownum, value_type v); // set all the pixels in entire row
+  void set_all(value_type v);             // set all the pixels in the image
+
+  // set every pixel in the rectangle [x0, x1) x [y0, y1), clipped to the
+  // image. Rows are written as whole spans, and when threads > 1 a large
+  // rectangle is split into bands of rows which are filled concurrently
+  void fill_rect(int x0, int y0, int x1, int y1, value_type v,
+                 unsigned threads = 1);
+  // set all the pixels in rows [y0, y1)
+  void fill_rows(int y0, int y1, value_type v, unsigned threads = 1);
+
+  // the colour drawn for a palette index
+  void set_colour(uint8_t index, pixel colour)
+    requires(Format::palette_size > 0)
+  {
+    palette[index] = {colour.blue, colour.green, colour.red, 0};
+  }
+
+  // save the image data to file
+  bool write(write_backend backend = write_backend::stream);
+  // save the image data to file, run length encoded if asked
+  bool write(bitmap_compression compression);
+};
+
+// the original 24 bit bitmap
+using bitmap = basic_bitmap<bgr24>;
+
+// one band of consecutive rows handed to a bitmap_stream_writer producer
+// row(0) is image row first_row. Only the first width pixels of a row may be
+// written, the bytes after them are the file padding
+struct pixel_band {
+  int first_row;
+  int rows;
+  int width;
+  uint8_t *data;
+  size_t stride;
+
+  pixel *row(int i) const {
+    return reinterpret_cast<pixel *>(data + i * stride);
+  }
 };
 
-class bitmap {
+// writes a 24 bit BMP without ever holding the whole image in memory
+// the producer is called with consecutive bands of band_rows rows, starting
+// at row 0, and each band is written to the file as soon as it is filled.
+// Peak memory is one band, so images much larger than RAM can be written
+class bitmap_stream_writer {
 
 private:
-  int width{800};
-  int height{600};
+  int width;
+  int height;
+  int band_rows;
   std::string filename;
-  std::vector<pixel> pixels;
 
 public:
-  bitmap(std::string filename) : filename(filename), pixels(width * height) {}
-  void set_pixel(int x, int y, pixel p); // set the pixel at (x, y)
-  void set_row(int rownum, pixel p);     // set all the pixels in entire row
-  void set_all(pixel p);                 // set all the pixels in the image
-  bool write();                          // save the image data to file
+  using producer = std::function<void(const pixel_band &)>;
+
+  bitmap_stream_writer(std::string filename, int width, int height,
+                       int band_rows = 64);
+  bool write(const producer &produce); // false if the file can't be written
 };
 
 #endif
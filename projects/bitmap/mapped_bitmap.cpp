@@ -0,0 +1,132 @@
+#include "mapped_bitmap.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+using namespace std;
+
+namespace {
+
+runtime_error map_error(const string &filename, const string &what) {
+  return runtime_error(filename + ": " + what);
+}
+
+} // namespace
+
+mapped_bitmap::mapped_bitmap(const string &filename) {
+  fd = ::open(filename.c_str(), O_RDWR);
+  if (fd < 0) {
+    throw map_error(filename, strerror(errno));
+  }
+
+  struct stat st {};
+  if (fstat(fd, &st) != 0) {
+    int err = errno;
+    close();
+    throw map_error(filename, strerror(err));
+  }
+  map_size = st.st_size;
+  if (map_size < sizeof(bitmap_file_header) + sizeof(bitmap_info_header)) {
+    close();
+    throw map_error(filename, "too small to be a bitmap");
+  }
+
+  void *addr =
+      mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED) {
+    int err = errno;
+    map_size = 0;
+    close();
+    throw map_error(filename, strerror(err));
+  }
+  map = static_cast<uint8_t *>(addr);
+
+  // the headers are not aligned in the file, so copy them out
+  bitmap_file_header file_header;
+  bitmap_info_header info_header;
+  memcpy(&file_header, map, sizeof(file_header));
+  memcpy(&info_header, map + sizeof(file_header), sizeof(info_header));
+
+  // larger info headers (V4, V5) start with the same fields
+  const char *problem = nullptr;
+  if (file_header.header[0] != 'B' || file_header.header[1] != 'M') {
+    problem = "not a bitmap";
+  } else if (info_header.header_size < 40) {
+    problem = "unsupported info header";
+  } else if (info_header.planes != 1 || info_header.bits_per_pixel != 24) {
+    problem = "only 24 bit bitmaps are supported";
+  } else if (info_header.compression != 0) {
+    problem = "compressed bitmaps are not supported";
+  } else if (info_header.width < 1 || info_header.height == 0 ||
+             info_header.width > pixel_storage::max_dimension ||
+             info_header.height > pixel_storage::max_dimension ||
+             info_header.height < -pixel_storage::max_dimension) {
+    problem = "bad image dimensions";
+  }
+
+  if (!problem) {
+    width = info_header.width;
+    top_down = info_header.height < 0;
+    height = top_down ? -info_header.height : info_header.height;
+    stride = (width * sizeof(pixel) + 3) / 4 * 4;
+    size_t offset = file_header.data_offset;
+    if (offset < sizeof(file_header) + info_header.header_size ||
+        offset > map_size || map_size - offset < stride * height) {
+      problem = "pixel data is truncated";
+    } else {
+      pixels = map + offset;
+    }
+  }
+
+  if (problem) {
+    close();
+    throw map_error(filename, problem);
+  }
+}
+
+mapped_bitmap::~mapped_bitmap() { close(); }
+
+mapped_bitmap::mapped_bitmap(mapped_bitmap &&other) noexcept
+    : fd(exchange(other.fd, -1)), map(exchange(other.map, nullptr)),
+      map_size(exchange(other.map_size, 0)), width(other.width),
+      height(other.height), top_down(other.top_down),
+      pixels(exchange(other.pixels, nullptr)), stride(other.stride) {}
+
+mapped_bitmap &mapped_bitmap::operator=(mapped_bitmap &&other) noexcept {
+  if (this != &other) {
+    close();
+    fd = exchange(other.fd, -1);
+    map = exchange(other.map, nullptr);
+    map_size = exchange(other.map_size, 0);
+    width = other.width;
+    height = other.height;
+    top_down = other.top_down;
+    pixels = exchange(other.pixels, nullptr);
+    stride = other.stride;
+  }
+  return *this;
+}
+
+// unmapping does not lose any edits, the kernel writes the pages back
+void mapped_bitmap::close() {
+  if (map) {
+    munmap(map, map_size);
+    map = nullptr;
+  }
+  if (fd >= 0) {
+    ::close(fd);
+    fd = -1;
+  }
+}
+
+void mapped_bitmap::set_row(int rownum, pixel p) {
+  fill_span(row(rownum), width, p);
+}
+
+bool mapped_bitmap::flush() { return msync(map, map_size, MS_SYNC) == 0; }
@@ -0,0 +1,58 @@
+#ifndef MAPPED_BITMAP_H
+#define MAPPED_BITMAP_H
+
+#include "bitmap.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// an existing 24 bit BMP file mapped into memory
+// the pixels are used in place, so set_pixel and set_row change the file
+// itself and nothing is copied however big the image is. Coordinates are the
+// same as for bitmap: row 0 is the first row of a bottom-up file, and for a
+// top-down file (negative height) the rows are flipped to match
+class mapped_bitmap {
+
+private:
+  int fd{-1};
+  uint8_t *map{nullptr};
+  size_t map_size{0};
+  int width{0};
+  int height{0};
+  bool top_down{false};
+  uint8_t *pixels{nullptr}; // first row in the file
+  size_t stride{0};         // padded row size in the file
+
+  void close();
+
+public:
+  // throws std::runtime_error if the file can't be mapped or is not an
+  // uncompressed 24 bit BMP
+  explicit mapped_bitmap(const std::string &filename);
+  ~mapped_bitmap();
+
+  mapped_bitmap(const mapped_bitmap &) = delete;
+  mapped_bitmap &operator=(const mapped_bitmap &) = delete;
+  mapped_bitmap(mapped_bitmap &&other) noexcept;
+  mapped_bitmap &operator=(mapped_bitmap &&other) noexcept;
+
+  int get_width() const { return width; }
+  int get_height() const { return height; }
+
+  pixel *row(int y) {
+    int file_row = top_down ? height - 1 - y : y;
+    return reinterpret_cast<pixel *>(pixels + file_row * stride);
+  }
+  const pixel *row(int y) const {
+    int file_row = top_down ? height - 1 - y : y;
+    return reinterpret_cast<const pixel *>(pixels + file_row * stride);
+  }
+
+  pixel get_pixel(int x, int y) const { return row(y)[x]; }
+  void set_pixel(int x, int y, pixel p) { row(y)[x] = p; }
+  void set_row(int rownum, pixel p); // set all the pixels in entire row
+  bool flush(); // write dirty pages back to the file now
+};
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef PIXEL_FORMAT_H
+#define PIXEL_FORMAT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// although general standars is RGB, but MS used BGR in bitmap which was
+// designed in 80's
+struct pixel {
+  uint8_t blue;
+  uint8_t green;
+  uint8_t red;
+};
+
+// a 32 bit pixel, and also the layout of a palette entry in the file
+struct pixel_bgra {
+  uint8_t blue;
+  uint8_t green;
+  uint8_t red;
+  uint8_t alpha;
+};
+
+// write n copies of p starting at dst
+void fill_span(pixel *dst, size_t n, pixel p);
+
+// Pixel formats for basic_bitmap
+// each format says how many bits a pixel takes in a row, what a pixel value
+// is, and how to store, load and fill pixels in a row of bytes. They are all
+// small static functions, so set_pixel is inlined for every format
+
+// 24 bit BGR, the original bitmap format
+struct bgr24 {
+  using value_type = pixel;
+  static constexpr int bits_per_pixel = 24;
+  static constexpr int palette_size = 0;
+
+  static void store(uint8_t *row, int x, pixel p) {
+    reinterpret_cast<pixel *>(row)[x] = p;
+  }
+  static pixel load(const uint8_t *row, int x) {
+    return reinterpret_cast<const pixel *>(row)[x];
+  }
+  static void fill(uint8_t *row, int x0, int x1, pixel p) {
+    fill_span(reinterpret_cast<pixel *>(row) + x0, x1 - x0, p);
+  }
+};
+
+// 32 bit BGRA, every pixel is one aligned word
+struct bgra32 {
+  using value_type = pixel_bgra;
+  static constexpr int bits_per_pixel = 32;
+  static constexpr int palette_size = 0;
+
+  static void store(uint8_t *row, int x, pixel_bgra p) {
+    std::memcpy(row + 4 * x, &p, 4);
+  }
+  static pixel_bgra load(const uint8_t *row, int x) {
+    pixel_bgra p;
+    std::memcpy(&p, row + 4 * x, 4);
+    return p;
+  }
+  static void fill(uint8_t *row, int x0, int x1, pixel_bgra p) {
+    auto *dst = reinterpret_cast<pixel_bgra *>(row);
+    std::fill(dst + x0, dst + x1, p);
+  }
+};
+
+// 1, 4 or 8 bit indices into a palette of 2, 16 or 256 colours
+// several pixels share a byte, and the leftmost pixel is in the high bits
+template <int Bits> struct indexed {
+  static_assert(Bits == 1 || Bits == 4 || Bits == 8,
+                "BMP palettes are 1, 4 or 8 bits per pixel");
+
+  using value_type = uint8_t;
+  static constexpr int bits_per_pixel = Bits;
+  static constexpr int palette_size = 1 << Bits;
+  static constexpr int per_byte = 8 / Bits;
+  static constexpr uint8_t mask = (1 << Bits) - 1;
+
+  static int shift(int x) { return (per_byte - 1 - x % per_byte) * Bits; }
+
+  static void store(uint8_t *row, int x, uint8_t index) {
+    if constexpr (Bits == 8) {
+      row[x] = index;
+    } else {
+      uint8_t &byte = row[x / per_byte];
+      byte = (byte & ~(mask << shift(x))) | ((index & mask) << shift(x));
+    }
+  }
+  static uint8_t load(const uint8_t *row, int x) {
+    if constexpr (Bits == 8) {
+      return row[x];
+    } else {
+      return (row[x / per_byte] >> shift(x)) & mask;
+    }
+  }
+
+  // the pixels before the first whole byte and after the last one are
+  // stored one by one, and the whole bytes in between are one memset
+  static void fill(uint8_t *row, int x0, int x1, uint8_t index) {
+    while (x0 < x1 && x0 % per_byte != 0) {
+      store(row, x0++, index);
+    }
+    while (x1 > x0 && x1 % per_byte != 0) {
+      store(row, --x1, index);
+    }
+    uint8_t pattern = 0;
+    for (int i = 0; i < per_byte; ++i) {
+      pattern = (pattern << Bits) | (index & mask);
+    }
+    std::memset(row + x0 / per_byte, pattern, (x1 - x0) / per_byte);
+  }
+};
+
+using indexed1 = indexed<1>;
+using indexed4 = indexed<4>;
+using indexed8 = indexed<8>;
+
+#endif